@@ -0,0 +1,52 @@
+#include "alloc_check.h"
+
+#ifdef TUO_ALLOC_CHECK
+
+#include <cstdlib>
+#include <new>
+
+namespace {
+thread_local uint64_t heap_allocations{0};
+}
+
+uint64_t thread_heap_allocations()
+{
+    return(heap_allocations);
+}
+//------------------------------------------------------------------------------
+// new[] ends up here too.
+void* operator new(std::size_t size)
+{
+    ++ heap_allocations;
+    void* ptr = std::malloc(size ? size : 1);
+    if (!ptr)
+    {
+        throw std::bad_alloc();
+    }
+    return(ptr);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+//------------------------------------------------------------------------------
+BattleAllocations& BattleAllocations::operator+=(const BattleAllocations& other)
+{
+    battles += other.battles;
+    checked_battles += other.checked_battles;
+    allocations += other.allocations;
+    return(*this);
+}
+//------------------------------------------------------------------------------
+void BattleAllocations::print(std::ostream& os) const
+{
+    if (checked_battles == 0)
+    {
+        return;
+    }
+    os << "Heap allocations: " << allocations << " in " << checked_battles << " battles (after "
+        << battles - checked_battles << " warm-up battles)\n";
+}
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef ALLOC_CHECK_H_INCLUDED
+#define ALLOC_CHECK_H_INCLUDED
+
+//---------------------- Heap allocation check --------------------------------
+// Build with -DTUO_ALLOC_CHECK (make alloccheck) to count the heap allocations
+// made by the battles. operator new is replaced by one that counts the
+// allocations of each thread; every battle (the resets of its hands and Field,
+// then play()) adds those it made to the counter of its SimulationData, once
+// the first alloc_check_warmup_battles battles have grown the buffers. The
+// Process adds them up and prints the report when it is destroyed.
+// Without TUO_ALLOC_CHECK the macro expands to nothing.
+#ifdef TUO_ALLOC_CHECK
+
+#include <cstdint>
+#include <ostream>
+
+const unsigned alloc_check_warmup_battles{100};
+
+// Heap allocations made by the calling thread so far.
+uint64_t thread_heap_allocations();
+
+struct BattleAllocations
+{
+    uint64_t battles{0};  // all of them, warm-up included
+    uint64_t checked_battles{0};
+    uint64_t allocations{0};  // during the checked battles
+
+    BattleAllocations& operator+=(const BattleAllocations& other);
+    void print(std::ostream& os) const;
+};
+
+class AllocCheckScope
+{
+public:
+    AllocCheckScope(BattleAllocations& counter_) :
+        counter(counter_),
+        start(thread_heap_allocations())
+    {
+    }
+
+    ~AllocCheckScope()
+    {
+        if (++ counter.battles > alloc_check_warmup_battles)
+        {
+            ++ counter.checked_battles;
+            counter.allocations += thread_heap_allocations() - start;
+        }
+    }
+
+private:
+    BattleAllocations& counter;
+    uint64_t start;
+};
+
+#define TUO_ALLOC_CHECK_BATTLE(counter) AllocCheckScope alloc_check_scope(counter)
+
+#else
+
+#define TUO_ALLOC_CHECK_BATTLE(counter)
+
+#endif
+
+#endif
@@ -0,0 +1,32 @@
+#!/bin/bash
+# Counts the heap allocations of the battles of the scenarios of scenarios.txt.
+# usage: alloccheck.sh <tuo built with -DTUO_ALLOC_CHECK> [iterations]
+#   prints one JSON object per scenario; exits 1 if a battle allocated after the
+#   warm-up (or if the binary reports nothing: not an alloccheck build).
+
+TUO=$(realpath "${1:?usage: alloccheck.sh <tuo> [iterations]}")
+ITERATIONS=${2:-2000}
+cd "$(dirname "$(realpath "$0")")" || exit 2
+
+status=0
+while IFS= read -r line; do
+    if [[ $line =~ ^// || -z ${line// } ]]; then
+        continue
+    fi
+    IFS="|" read -r name iterations args _ <<< "$line"
+    name=$(echo $name)
+    eval "set -- $args"
+
+    output=$("$TUO" "$@" -t 1 seed 1 sim "$ITERATIONS" 2>&1)
+    # "Heap allocations: 0 in 9900 battles (after 100 warm-up battles)"
+    report=$(sed -n "s/^Heap allocations: \([0-9]*\) in \([0-9]*\) battles.*/\1 \2/p" <<< "$output")
+    if [[ -z $report ]]; then
+        echo "{\"scenario\": \"$name\", \"error\": \"no allocation report\"}"
+        status=1
+        continue
+    fi
+    read -r allocations battles <<< "$report"
+    (( allocations == 0 )) || status=1
+    echo "{\"scenario\": \"$name\", \"battles\": $battles, \"allocations\": $allocations}"
+done < scenarios.txt
+exit $status
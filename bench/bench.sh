@@ -0,0 +1,80 @@
+#!/bin/bash
+# Times play() over the scenarios of scenarios.txt and checks their results.
+# usage: bench.sh <tuo> [record]
+#   prints one JSON object per scenario; exits 1 if a result differs from its
+#   golden. With "record", writes the current results as the new goldens.
+
+TUO=$(realpath "${1:?usage: bench.sh <tuo> [record]}")
+RECORD=$2
+cd "$(dirname "$(realpath "$0")")" || exit 2
+
+# nanoseconds since the epoch (BSD date has no %N)
+if [[ $(date +%N) == N ]]; then
+    now_ns() { perl -MTime::HiRes=time -e 'printf("%d", time * 1e9)'; }
+else
+    now_ns() { date +%s%N; }
+fi
+
+# run_tuo <iterations> <arguments...>: elapsed nanoseconds on the first line, output after
+run_tuo()
+{
+    local iterations=$1; shift
+    local start=$(now_ns)
+    local output
+    output=$("$TUO" "$@" -t 1 seed 1 sim "$iterations" 2>&1)
+    echo $(( $(now_ns) - start ))
+    echo "$output"
+}
+
+# "win%: 54.75 (1095 / 2000)" -> 1095; one count per enemy deck: "win%: 53.3 (40 25 95 / 100)" -> 40 25 95
+count() { sed -n "s/^$1%: .*(\([0-9 ]*\) \/ [0-9]*)$/\1/p" <<< "$2"; }
+
+status=0
+new_scenarios=""
+while IFS= read -r line; do
+    if [[ $line =~ ^// || -z ${line// } ]]; then
+        new_scenarios+="$line"$'\n'
+        continue
+    fi
+    IFS='|' read -r name iterations args golden <<< "$line"
+    name=$(echo $name); iterations=$(echo $iterations); golden=$(echo $golden)
+    eval "set -- $args"
+
+    warmup=$(run_tuo 0 "$@")
+    output=$(run_tuo "$iterations" "$@")
+    wins=$(count win "$output"); stalls=$(count stall "$output"); losses=$(count loss "$output")
+    if [[ -z $wins || -z $stalls || -z $losses ]]; then
+        echo "{\"scenario\": \"$name\", \"error\": \"no results\"}"
+        grep -m3 -i "error" <<< "$output" >&2
+        status=1
+        new_scenarios+="$line"$'\n'
+        continue
+    fi
+    result="$wins / $stalls / $losses"
+    ns=$(( $(head -1 <<< "$output") - $(head -1 <<< "$warmup") ))
+    (( ns > 0 )) || ns=1
+    if [[ -n $RECORD ]]; then
+        match=recorded
+        new_scenarios+="${line%|*}| $result"$'\n'
+    elif [[ $result == "$golden" ]]; then
+        match=true
+    else
+        match=false
+        status=1
+    fi
+    awk -v name="$name" -v n="$iterations" -v ns="$ns" -v w="$wins" -v s="$stalls" -v l="$losses" -v g="$golden" -v m="$match" 'BEGIN {
+        # sim <iterations> plays that many battles against each enemy deck
+        n *= split(w, counts, " ")
+        printf("{\"scenario\": \"%s\", \"battles\": %d, \"seconds\": %.3f, \"battles_per_sec\": %.1f, \"wins\": [%s], \"stalls\": [%s], \"losses\": [%s], \"golden\": \"%s\", \"match\": %s}\n",
+            name, n, ns / 1e9, n * 1e9 / ns, list(w), list(s), list(l), g, m == "recorded" ? "\"recorded\"" : m)
+    }
+    function list(counts) {
+        gsub(/ /, ", ", counts)
+        return(counts)
+    }'
+done < scenarios.txt
+
+if [[ -n $RECORD ]]; then
+    printf "%s" "$new_scenarios" > scenarios.txt
+fi
+exit $status
@@ -0,0 +1,32 @@
+#!/bin/bash
+# Plays the scenarios of lockstep.txt with play() and with the lockstep engine.
+# usage: lockstep.sh <tuo built with -DTUO_LOCKSTEP>
+#   prints the lockstepbench table of each scenario; exits 1 if a battle of the
+#   lockstep engine differs from the same battle of play() (or if the binary
+#   reports nothing: not a lockstep build).
+
+TUO=$(realpath "${1:?usage: lockstep.sh <tuo>}")
+cd "$(dirname "$(realpath "$0")")" || exit 2
+
+status=0
+while IFS= read -r line; do
+    if [[ $line =~ ^// || -z ${line// } ]]; then
+        continue
+    fi
+    IFS="|" read -r name battles args _ <<< "$line"
+    name=$(echo $name)
+    eval "set -- $args"
+
+    output=$("$TUO" "$@" -t 1 seed 1 lockstepbench $battles 2>&1)
+    echo "== $name"
+    sed -n '/^deck /,$p' <<< "$output"
+    # "Lockstep mismatches: 0 in 80000 battles"
+    mismatches=$(sed -n "s/^Lockstep mismatches: \([0-9]*\) in .*/\1/p" <<< "$output")
+    if [[ -z $mismatches ]]; then
+        echo "$output"
+        status=1
+    elif (( mismatches != 0 )); then
+        status=1
+    fi
+done < lockstep.txt
+exit $status
@@ -0,0 +1,72 @@
+// Checks that crn_battle_seed() gives a different seed to every battle, enemy deck and stream
+// of a run, over the battles and gauntlet sizes of real climbs, and that seed_random_engine()
+// keeps all the bits of these seeds: seeds that only differ in their high 32 bits must start
+// different streams of the RandomEngine.
+// usage: seed_check (built by "make seedcheck", for each RandomEngine); exits 1 on a repeated seed or stream.
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include "../tyrant.h"
+
+namespace {
+const unsigned num_battles{20000};
+const unsigned num_decks{128};
+const unsigned num_candidates{100000};
+const unsigned num_engines{20000};
+
+// The first 64 bits of the stream of the RandomEngine seeded with seed.
+uint64_t stream_start(uint64_t seed)
+{
+    RandomEngine re;
+    seed_random_engine(re, seed);
+    uint64_t start = re();
+    return (start << 32) | re();
+}
+}
+
+int main()
+{
+    int status(0);
+    for (unsigned base_seed: {0u, 1u, 2654435761u, UINT32_MAX})
+    {
+        std::vector<uint64_t> seeds;
+        seeds.reserve(num_battles * num_decks * 3 + num_candidates);
+        for (unsigned battle_index(0); battle_index < num_battles; ++ battle_index)
+        {
+            for (unsigned deck_index(0); deck_index < num_decks; ++ deck_index)
+            {
+                for (unsigned stream(0); stream < 3; ++ stream)
+                {
+                    seeds.push_back(crn_battle_seed(base_seed, battle_index, deck_index, stream));
+                }
+            }
+        }
+        // par-candidates: one seed per compared candidate
+        for (unsigned candidate_index(0); candidate_index < num_candidates; ++ candidate_index)
+        {
+            seeds.push_back(crn_battle_seed(base_seed, candidate_index, 0, 3));
+        }
+        // engines seeded with the first seeds, and with these seeds with their high 32 bits flipped
+        std::vector<uint64_t> starts;
+        starts.reserve(2 * num_engines);
+        for (unsigned seed_index(0); seed_index < num_engines; ++ seed_index)
+        {
+            starts.push_back(stream_start(seeds[seed_index]));
+            starts.push_back(stream_start(seeds[seed_index] ^ 0xffffffff00000000ULL));
+        }
+        std::sort(seeds.begin(), seeds.end());
+        auto repeated = std::adjacent_find(seeds.begin(), seeds.end());
+        std::sort(starts.begin(), starts.end());
+        auto repeated_start = std::adjacent_find(starts.begin(), starts.end());
+        std::cout << "{\"base_seed\": " << base_seed << ", \"seeds\": " << seeds.size()
+            << ", \"repeated\": " << (repeated != seeds.end() ? "true" : "false")
+            << ", \"engines\": " << starts.size()
+            << ", \"repeated_stream\": " << (repeated_start != starts.end() ? "true" : "false") << "}\n";
+        if (repeated != seeds.end() || repeated_start != starts.end())
+        {
+            status = 1;
+        }
+    }
+    return(status);
+}
@@ -21,7 +21,10 @@ public:
     unsigned m_rarity;
     unsigned m_set;
     std::vector<SkillSpec> m_skills;
+    std::vector<SkillSpec> m_activation_skills; // m_skills filtered by is_activation_skill(), set by Cards::organize()
     unsigned m_skill_value[Skill::num_skills];
+    uint8_t m_skill_slot[Skill::num_skills];
+    unsigned m_num_skill_slots;
     CardType::CardType m_type;
     CardCategory::CardCategory m_category;
     const Card* m_top_level_card; // [TU] corresponding full-level card
@@ -43,6 +46,8 @@ public:
         m_rarity(1),
         m_set(0),
         m_skills(),
+        m_activation_skills(),
+        m_num_skill_slots(0),
         m_type(CardType::assault),
         m_category(CardCategory::normal),
         m_top_level_card(this),
@@ -51,8 +56,10 @@ public:
         m_used_for_cards()
     {
         std::memset(m_skill_value, 0, sizeof m_skill_value);
+        std::memset(m_skill_slot, 0, sizeof m_skill_slot);
     }
 
+    void clear_skills();
     void add_skill(Skill::Skill id, unsigned x, Faction y, unsigned n, unsigned c, Skill::Skill s, Skill::Skill s2, bool all);
     const Card* upgraded() const { return this == m_top_level_card ? this : m_used_for_cards.begin()->first; }
     const Card* downgraded() const { return m_level == 1 ? this : m_recipe_cards.begin()->first; }
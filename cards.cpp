@@ -1,6 +1,7 @@
 #include "cards.h"
 
 #include <boost/tokenizer.hpp>
+#include <algorithm>
 #include <sstream>
 #include <stdexcept>
 #include <cstring>
@@ -79,6 +80,15 @@ void Cards::organize()
         {
             card->m_name.erase(pos, 1);
         }
+        // precompute the skills evaluate_skills() has to walk each action
+        card->m_activation_skills.clear();
+        for (const auto & ss: card->m_skills)
+        {
+            if (is_activation_skill(ss.id))
+            {
+                card->m_activation_skills.push_back(ss);
+            }
+        }
         // set m_top_level_card for non base cards
         card->m_top_level_card = by_id(card->m_base_id)->m_top_level_card;
         // Cards available ("visible") to players have priority
@@ -112,6 +122,57 @@ void Cards::organize()
 #endif
 }
 
+// Evolve gives a unit skills its card does not have, each in a skill slot of its own.
+// Check that every card of field_cards (the cards the battles can field) has slots for its skills
+// and for all the skills the evolve skills of these cards and of the BGEs can turn them into.
+void check_skill_slots(const std::vector<const Card*>& field_cards, const std::vector<SkillSpec>& your_bg_skills, const std::vector<SkillSpec>& enemy_bg_skills)
+{
+    std::vector<std::pair<Skill::Skill, Skill::Skill>> evolves;
+    auto add_evolves = [&evolves](const std::vector<SkillSpec>& skills)
+    {
+        for (const auto & ss: skills)
+        {
+            if (ss.id == Skill::evolve) { evolves.emplace_back(ss.s, ss.s2); }
+        }
+    };
+    for (const Card* card: field_cards)
+    {
+        add_evolves(card->m_skills);
+    }
+    add_evolves(your_bg_skills);
+    add_evolves(enemy_bg_skills);
+    std::sort(evolves.begin(), evolves.end());
+    evolves.erase(std::unique(evolves.begin(), evolves.end()), evolves.end());
+
+    for (const Card* card: field_cards)
+    {
+        bool has_skill[Skill::num_skills] = {};
+        for (const auto & ss: card->m_skills)
+        {
+            has_skill[ss.id] = true;
+        }
+        unsigned num_slots = card->m_num_skill_slots + 1;
+        for (bool evolved = true; evolved; )
+        {
+            evolved = false;
+            for (const auto & evolve: evolves)
+            {
+                if (has_skill[evolve.first] && !has_skill[evolve.second])
+                {
+                    has_skill[evolve.second] = true;
+                    ++ num_slots;
+                    evolved = true;
+                }
+            }
+        }
+        if (num_slots > max_skill_slots)
+        {
+            throw std::runtime_error("Card " + card->m_name + ": its skills and the skills evolve can give it need "
+                + to_string(num_slots - 1) + " skill slots, at most " + to_string(max_skill_slots - 1) + " are supported");
+        }
+    }
+}
+
 void Cards::add_card(Card * card, const std::string & name)
 {
     std::string simple_name{simplify_name(name)};
@@ -157,6 +218,14 @@ void Cards::add_card(Card * card, const std::string & name)
 }
 
 // class Card
+void Card::clear_skills()
+{
+    m_skills.clear();
+    std::memset(m_skill_value, 0, sizeof m_skill_value);
+    std::memset(m_skill_slot, 0, sizeof m_skill_slot);
+    m_num_skill_slots = 0;
+}
+//------------------------------------------------------------------------------
 void Card::add_skill(Skill::Skill id, unsigned x, Faction y, unsigned n, unsigned c, Skill::Skill s, Skill::Skill s2, bool all)
 {
     for(auto it = m_skills.begin(); it != m_skills.end(); ++ it)
@@ -167,6 +236,10 @@ void Card::add_skill(Skill::Skill id, unsigned x, Faction y, unsigned n, unsigne
             break;
         }
     }
+    if(m_skill_slot[id] == 0)
+    {
+        m_skill_slot[id] = ++ m_num_skill_slots;
+    }
     m_skills.push_back({id, x, y, n, c, s, s2, all});
     m_skill_value[id] = x ? x : n ? n : 1;
 }
@@ -7,6 +7,7 @@
 #include <vector>
 
 class Card;
+struct SkillSpec;
 
 class Cards
 {
@@ -29,5 +30,6 @@ public:
 };
 
 std::string simplify_name(const std::string& card_name);
+void check_skill_slots(const std::vector<const Card*>& field_cards, const std::vector<SkillSpec>& your_bg_skills, const std::vector<SkillSpec>& enemy_bg_skills);
 
 #endif
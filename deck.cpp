@@ -345,6 +345,36 @@ std::string Deck::hash() const
     return ios.str();
 }
 
+void DeckFingerprint::add(const Card* card, unsigned position)
+{
+    uint64_t key = ((uint64_t)card->m_id << 32) | position;
+    low += fingerprint_mix(key);
+    high += fingerprint_mix(~key);
+}
+
+void DeckFingerprint::remove(const Card* card, unsigned position)
+{
+    uint64_t key = ((uint64_t)card->m_id << 32) | position;
+    low -= fingerprint_mix(key);
+    high -= fingerprint_mix(~key);
+}
+
+DeckFingerprint Deck::fingerprint() const
+{
+    DeckFingerprint res;
+    res.add(commander);
+    for (const Card* card: dominion_cards)
+    {
+        res.add(card);
+    }
+    bool is_ordered = strategy != DeckStrategy::random;
+    for (unsigned i = 0; i < cards.size(); ++ i)
+    {
+        res.add(cards[i], is_ordered ? i + 1 : 0);
+    }
+    return res;
+}
+
 std::string Deck::short_description() const
 {
     std::stringstream ios;
@@ -483,7 +513,7 @@ const Card* Deck::next()
     else if(strategy == DeckStrategy::random || strategy == DeckStrategy::exact_ordered)
     {
         const Card* card = shuffled_cards.front();
-        shuffled_cards.pop_front();
+        shuffled_cards.erase(shuffled_cards.begin());
         return(card);
     }
     else if(strategy == DeckStrategy::ordered)
@@ -520,14 +550,14 @@ const Card* Deck::next()
     throw std::runtime_error("Unknown strategy for deck.");
 }
 
-const Card* Deck::upgrade_card(const Card* card, unsigned card_max_level, std::mt19937& re, unsigned &remaining_upgrade_points, unsigned &remaining_upgrade_opportunities)
+const Card* Deck::upgrade_card(const Card* card, unsigned card_max_level, RandomEngine& re, unsigned &remaining_upgrade_points, unsigned &remaining_upgrade_opportunities)
 {
     unsigned oppos = card_max_level - card->m_level;
     if (remaining_upgrade_points > 0)
     {
         for (; oppos > 0; -- oppos)
         {
-            std::mt19937::result_type rnd = re();
+            RandomEngine::result_type rnd = re();
             if (rnd % remaining_upgrade_opportunities < remaining_upgrade_points)
             {
                 card = card->upgraded();
@@ -539,7 +569,7 @@ const Card* Deck::upgrade_card(const Card* card, unsigned card_max_level, std::m
     return card;
 }
 
-void Deck::shuffle(std::mt19937& re)
+void Deck::shuffle(RandomEngine& re)
 {
     shuffled_commander = commander;
     shuffled_forts.clear();
@@ -569,9 +599,9 @@ void Deck::shuffle(std::mt19937& re)
     {
         unsigned remaining_upgrade_points = upgrade_points;
         unsigned remaining_upgrade_opportunities = upgrade_opportunities;
-        std::vector<std::pair<std::deque<const Card*>*, unsigned>> reup_cards;
+        std::vector<std::pair<std::vector<const Card*>*, unsigned>> reup_cards;
         shuffled_commander = upgrade_card(commander, commander_max_level, re, remaining_upgrade_points, remaining_upgrade_opportunities);
-        std::deque<const Card*> commander_storage;
+        std::vector<const Card*> commander_storage;
         commander_storage.emplace_back(shuffled_commander);
         reup_cards.emplace_back(&commander_storage, 0);
         unsigned index(0);
@@ -591,8 +621,8 @@ void Deck::shuffle(std::mt19937& re)
         {
             for (auto reup_iter2 = std::next(reup_iter1); reup_iter2 != reup_cards.end(); ++ reup_iter2)
             {
-                std::deque<const Card*> * card_storage1 = reup_iter1->first;
-                std::deque<const Card*> * card_storage2 = reup_iter2->first;
+                std::vector<const Card*> * card_storage1 = reup_iter1->first;
+                std::vector<const Card*> * card_storage2 = reup_iter2->first;
                 unsigned index1 = reup_iter1->second;
                 unsigned index2 = reup_iter2->second;
                 if (re() % 2)
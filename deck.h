@@ -37,6 +37,30 @@ void encode_deck_ddd_b64(std::stringstream &ios, std::vector<const Card*> cards)
 extern DeckDecoder hash_to_ids;
 extern DeckEncoder encode_deck;
 
+//------------------------------------------------------------------------------
+// splitmix64 finalizer
+inline uint64_t fingerprint_mix(uint64_t z)
+{
+    z += 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// 128-bit fingerprint of the cards of a deck: the sum of one term per card, so
+// that a card can be added or removed without going over the whole deck. The
+// term of a card of an ordered deck also depends on its position (1-based; 0
+// for the commander, the dominions and the cards of a random deck).
+struct DeckFingerprint
+{
+    uint64_t low{0};
+    uint64_t high{0};
+
+    void add(const Card* card, unsigned position = 0);
+    void remove(const Card* card, unsigned position = 0);
+    bool operator==(const DeckFingerprint& other) const { return low == other.low && high == other.high; }
+};
+
 //------------------------------------------------------------------------------
 // No support for ordered raid decks
 class Deck
@@ -56,8 +80,9 @@ public:
     std::map<signed, char> card_marks;  // <positions of card, prefix mark>: -1 indicating the commander. E.g, used as a mark to be kept in attacking deck when optimizing.
 
     const Card* shuffled_commander;
-    std::deque<const Card*> shuffled_forts;
-    std::deque<const Card*> shuffled_cards;
+    // cards are drawn from the front; a shuffle reuses the capacity of the previous battle
+    std::vector<const Card*> shuffled_forts;
+    std::vector<const Card*> shuffled_cards;
 
     // card id -> card order
     std::map<unsigned, std::list<unsigned>> order;
@@ -133,13 +158,14 @@ public:
 
     Deck* clone() const;
     std::string hash() const;
+    DeckFingerprint fingerprint() const;  // same decks as hash()
     std::string short_description() const;
     std::string medium_description() const;
     std::string long_description() const;
     void show_upgrades(std::stringstream &ios, const Card* card, unsigned card_max_level, const char * leading_chars) const;
     const Card* next();
-    const Card* upgrade_card(const Card* card, unsigned card_max_level, std::mt19937& re, unsigned &remaining_upgrade_points, unsigned &remaining_upgrade_opportunities);
-    void shuffle(std::mt19937& re);
+    const Card* upgrade_card(const Card* card, unsigned card_max_level, RandomEngine& re, unsigned &remaining_upgrade_points, unsigned &remaining_upgrade_opportunities);
+    void shuffle(RandomEngine& re);
     void place_at_bottom(const Card* card);
 };
 
@@ -0,0 +1,310 @@
+#include "lockstep.h"
+
+#ifdef TUO_LOCKSTEP
+
+#include <algorithm>
+#include <cstring>
+#include <emmintrin.h>
+#include "card.h"
+#include "deck.h"
+
+namespace {
+// All the values of the lanes are below 0x8000, so the signed comparisons of SSE2 work on them.
+const unsigned max_lockstep_value{0x7fff};
+
+inline __m128i load(const uint16_t* p)
+{
+    return(_mm_load_si128(reinterpret_cast<const __m128i*>(p)));
+}
+
+inline void store(uint16_t* p, __m128i v)
+{
+    _mm_store_si128(reinterpret_cast<__m128i*>(p), v);
+}
+
+// The 16 bits of movemask_epi8 of lane #i are bits #2i and #2i+1.
+inline bool lane_set(int mask, unsigned lane)
+{
+    return(mask & (1 << (2 * lane)));
+}
+
+bool lockstep_card_supported(const Card* card)
+{
+    if (card->m_attack > max_lockstep_value || card->m_health > max_lockstep_value || card->m_delay > max_lockstep_value)
+    {
+        return(false);
+    }
+    for (const auto & ss: card->m_skills)
+    {
+        if (card->m_type != CardType::assault || (ss.id != Skill::poison && ss.id != Skill::refresh)
+            || card->m_skill_value[ss.id] > max_lockstep_value)
+        {
+            return(false);
+        }
+    }
+    return(true);
+}
+
+bool lockstep_cards_supported(const std::vector<const Card*>& cards)
+{
+    return(std::all_of(cards.begin(), cards.end(), lockstep_card_supported));
+}
+
+// Takes the draws of both hands into the lane, or returns false if a card of the battle needs play().
+// The cards of a deck are all checked before the first draw, so that play() can still draw them.
+bool lockstep_draw(Field* fd, LockstepBoard& board, unsigned lane)
+{
+    for (unsigned player(0); player < 2; ++ player)
+    {
+        const Deck* deck(fd->players[player]->deck);
+        if (!lockstep_card_supported(fd->players[player]->commander.m_card)
+            || !lockstep_cards_supported(deck->dominion_cards) || !lockstep_cards_supported(deck->shuffled_forts)
+            || !lockstep_cards_supported(deck->shuffled_cards))
+        {
+            return(false);
+        }
+    }
+    for (unsigned player(0); player < 2; ++ player)
+    {
+        Deck* deck(fd->players[player]->deck);
+        auto & draws = board.draws[player][lane];
+        draws.clear();
+        // a side plays a card every other turn
+        for (const Card* card; draws.size() < (turn_limit + 1) / 2 && (card = deck->next()); )
+        {
+            draws.push_back(card);
+        }
+        board.next_draw[player][lane] = 0;
+        board.commander_hp[player][lane] = fd->players[player]->commander.m_hp;
+    }
+    return(true);
+}
+
+void clear_lane(LockstepBoard& board, unsigned lane)
+{
+    for (unsigned side(0); side < 2; ++ side)
+    {
+        for (unsigned slot(0); slot < board.num_assaults[side][lane]; ++ slot)
+        {
+            board.hp[side][slot][lane] = 0;
+        }
+        board.num_assaults[side][lane] = 0;
+    }
+}
+
+// Slots holding an assault in at least one running lane.
+unsigned num_slots(const LockstepBoard& board, unsigned side)
+{
+    unsigned slots(0);
+    for (unsigned lane(0); lane < lockstep_lanes; ++ lane)
+    {
+        if (board.running[lane])
+        {
+            slots = std::max<unsigned>(slots, board.num_assaults[side][lane]);
+        }
+    }
+    return(slots);
+}
+
+void play_cards(LockstepBoard& board, unsigned side)
+{
+    for (unsigned lane(0); lane < lockstep_lanes; ++ lane)
+    {
+        if (!board.running[lane] || board.next_draw[side][lane] == board.draws[side][lane].size())
+        {
+            continue;
+        }
+        const Card* card(board.draws[side][lane][board.next_draw[side][lane] ++]);
+        // structures without skill change nothing
+        if (card->m_type != CardType::assault)
+        {
+            continue;
+        }
+        unsigned slot(board.num_assaults[side][lane] ++);
+        board.hp[side][slot][lane] = card->m_health;
+        board.max_hp[side][slot][lane] = card->m_health;
+        board.attack[side][slot][lane] = card->m_attack;
+        board.delay[side][slot][lane] = card->m_delay;
+        board.poison[side][slot][lane] = card->m_skill_value[Skill::poison];
+        board.refresh[side][slot][lane] = card->m_skill_value[Skill::refresh];
+        board.poisoned[side][slot][lane] = 0;
+    }
+}
+
+// Compacts the assaults that survive to the front of the running lanes that have dead ones.
+void remove_dead(LockstepBoard& board, unsigned side)
+{
+    const __m128i zero(_mm_setzero_si128());
+    const __m128i num_assaults(load(board.num_assaults[side]));
+    __m128i dead(_mm_setzero_si128());
+    for (unsigned slot(0), end(num_slots(board, side)); slot < end; ++ slot)
+    {
+        __m128i occupied(_mm_cmpgt_epi16(num_assaults, _mm_set1_epi16(slot)));
+        dead = _mm_or_si128(dead, _mm_and_si128(occupied, _mm_cmpeq_epi16(load(board.hp[side][slot]), zero)));
+    }
+    int dead_mask(_mm_movemask_epi8(_mm_and_si128(dead, load(board.running))));
+    for (unsigned lane(0); dead_mask && lane < lockstep_lanes; ++ lane)
+    {
+        if (!lane_set(dead_mask, lane))
+        {
+            continue;
+        }
+        unsigned head(0);
+        for (unsigned current(0); current < board.num_assaults[side][lane]; ++ current)
+        {
+            if (board.hp[side][current][lane] == 0)
+            {
+                continue;
+            }
+            if (current != head)
+            {
+                board.hp[side][head][lane] = board.hp[side][current][lane];
+                board.max_hp[side][head][lane] = board.max_hp[side][current][lane];
+                board.attack[side][head][lane] = board.attack[side][current][lane];
+                board.delay[side][head][lane] = board.delay[side][current][lane];
+                board.poison[side][head][lane] = board.poison[side][current][lane];
+                board.refresh[side][head][lane] = board.refresh[side][current][lane];
+                board.poisoned[side][head][lane] = board.poisoned[side][current][lane];
+            }
+            ++ head;
+        }
+        for (unsigned slot(head); slot < board.num_assaults[side][lane]; ++ slot)
+        {
+            board.hp[side][slot][lane] = 0;
+        }
+        board.num_assaults[side][lane] = head;
+    }
+}
+}  // namespace
+//------------------------------------------------------------------------------
+LockstepBoard::LockstepBoard()
+{
+    std::memset(hp, 0, sizeof hp);
+    std::memset(num_assaults, 0, sizeof num_assaults);
+    std::memset(running, 0, sizeof running);
+    for (unsigned side(0); side < 2; ++ side)
+    {
+        for (unsigned lane(0); lane < lockstep_lanes; ++ lane)
+        {
+            draws[side][lane].reserve(max_board_units);
+        }
+    }
+}
+//------------------------------------------------------------------------------
+bool lockstep_field_supported(const Field* fd)
+{
+    switch (fd->optimization_mode)
+    {
+    case OptimizationMode::notset:
+    case OptimizationMode::winrate:
+    case OptimizationMode::defense:
+    case OptimizationMode::war:
+        break;
+    default:
+        return(false);
+    }
+    return((fd->gamemode == fight || fd->gamemode == surge) && !fd->bg_effects_mask
+        && fd->bg_skills[0].empty() && fd->bg_skills[1].empty()
+        && fd->players[0]->deck->vip_cards.empty());
+}
+//------------------------------------------------------------------------------
+// The turns follow play_turns(): the delays of the active side count down, it
+// plays a card, then each of its assaults that can attack hits the unit across
+// if it is alive (and poisons it), else the enemy commander. At the end of the
+// turn its assaults refresh, then take their poison damage, and the dead units
+// of both sides leave the board.
+unsigned play_lockstep(Field* fd, LockstepBoard& board, Results<uint64_t> (&results)[lockstep_lanes])
+{
+    const bool supported(lockstep_field_supported(fd));
+    unsigned num_lanes(0);
+    for (unsigned lane(0); lane < lockstep_lanes; ++ lane)
+    {
+        fd->players[0]->reset(fd->re);
+        fd->players[1]->reset(fd->re);
+        fd->reset();
+        clear_lane(board, lane);
+        board.running[lane] = 0;
+        if (!supported || !lockstep_draw(fd, board, lane))
+        {
+            results[lane] = play(fd);
+            continue;
+        }
+        board.running[lane] = 0xffff;
+        ++ num_lanes;
+    }
+    if (!num_lanes)
+    {
+        return(0);
+    }
+
+    const __m128i zero(_mm_setzero_si128());
+    const __m128i one(_mm_set1_epi16(1));
+    unsigned tapi(fd->gamemode == surge ? 1 : 0);
+    for (unsigned turn(1); turn <= turn_limit; ++ turn, tapi = 1 - tapi)
+    {
+        const unsigned tipi(1 - tapi);
+        __m128i running(load(board.running));
+        if (!_mm_movemask_epi8(running))
+        {
+            break;
+        }
+
+        for (unsigned slot(0), end(num_slots(board, tapi)); slot < end; ++ slot)
+        {
+            store(board.delay[tapi][slot], _mm_subs_epu16(load(board.delay[tapi][slot]), one));
+        }
+        play_cards(board, tapi);
+
+        const unsigned end_slot(num_slots(board, tapi));
+        __m128i commander_hp(load(board.commander_hp[tipi]));
+        for (unsigned slot(0); slot < end_slot; ++ slot)
+        {
+            __m128i attack(load(board.attack[tapi][slot]));
+            __m128i acts(_mm_and_si128(running, _mm_cmpgt_epi16(load(board.hp[tapi][slot]), zero)));
+            acts = _mm_and_si128(acts, _mm_cmpeq_epi16(load(board.delay[tapi][slot]), zero));
+            acts = _mm_and_si128(acts, _mm_cmpgt_epi16(attack, zero));
+            __m128i damage(_mm_and_si128(acts, attack));
+            __m128i def_hp(load(board.hp[tipi][slot]));
+            __m128i def_alive(_mm_cmpgt_epi16(def_hp, zero));
+            store(board.hp[tipi][slot], _mm_subs_epu16(def_hp, _mm_and_si128(def_alive, damage)));
+            __m128i poison(_mm_and_si128(_mm_and_si128(acts, def_alive), load(board.poison[tapi][slot])));
+            store(board.poisoned[tipi][slot], _mm_max_epi16(load(board.poisoned[tipi][slot]), poison));
+            commander_hp = _mm_subs_epu16(commander_hp, _mm_andnot_si128(def_alive, damage));
+        }
+        store(board.commander_hp[tipi], commander_hp);
+
+        int ended(_mm_movemask_epi8(_mm_and_si128(running, _mm_cmpeq_epi16(commander_hp, zero))));
+        for (unsigned lane(0); ended && lane < lockstep_lanes; ++ lane)
+        {
+            if (lane_set(ended, lane))
+            {
+                results[lane] = tapi == 0 ? Results<uint64_t>{1, 0, 0, 100} : Results<uint64_t>{0, 0, 1, 0};
+                board.running[lane] = 0;
+            }
+        }
+
+        for (unsigned slot(0); slot < end_slot; ++ slot)
+        {
+            __m128i hp(load(board.hp[tapi][slot]));
+            __m128i alive(_mm_cmpgt_epi16(hp, zero));
+            hp = _mm_min_epi16(_mm_adds_epi16(hp, _mm_and_si128(alive, load(board.refresh[tapi][slot]))), load(board.max_hp[tapi][slot]));
+            hp = _mm_subs_epu16(hp, _mm_and_si128(alive, load(board.poisoned[tapi][slot])));
+            store(board.hp[tapi][slot], hp);
+        }
+        remove_dead(board, tapi);
+        remove_dead(board, tipi);
+    }
+
+    const Results<uint64_t> stall{0, 1, 0, fd->optimization_mode == OptimizationMode::defense ? 100u : 0u};
+    for (unsigned lane(0); lane < lockstep_lanes; ++ lane)
+    {
+        if (board.running[lane])
+        {
+            results[lane] = stall;
+            board.running[lane] = 0;
+        }
+    }
+    return(num_lanes);
+}
+
+#endif
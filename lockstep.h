@@ -0,0 +1,58 @@
+#ifndef LOCKSTEP_H_INCLUDED
+#define LOCKSTEP_H_INCLUDED
+
+//---------------------- Lockstep battle engine --------------------------------
+// Build with -DTUO_LOCKSTEP (make lockstep) for an experimental engine that
+// plays lockstep_lanes battles of a Field at once, one battle in each 16-bit
+// lane of SSE2 registers: the units of a board slot are stored side by side
+// for all the lanes, so each step of a turn is a few vector operations for all
+// the battles. It only knows the battles without BGE, in the fight and surge
+// game modes and the winrate, defense and war optimization modes, whose
+// commanders and structures have no skill and whose assaults have no skill but
+// poison and refresh. play_lockstep() hands any other battle to play() as it
+// draws it; the decks are drawn in the order play() would draw them and the
+// lockstep battles take no random number, so both engines play the same
+// battles from the same seed.
+// Only the lockstepbench operation uses it.
+#ifdef TUO_LOCKSTEP
+
+#ifndef __SSE2__
+#error "TUO_LOCKSTEP needs SSE2"
+#endif
+
+#include <cstdint>
+#include <vector>
+#include "sim.h"
+
+const unsigned lockstep_lanes{8};
+
+// The boards of the battles of the lanes. [side][slot][lane]: the assaults of
+// a lane are in slots 0 to num_assaults - 1, in board order; the other slots
+// have no hp.
+struct LockstepBoard
+{
+    alignas(16) uint16_t hp[2][max_board_units][lockstep_lanes];
+    alignas(16) uint16_t max_hp[2][max_board_units][lockstep_lanes];
+    alignas(16) uint16_t attack[2][max_board_units][lockstep_lanes];
+    alignas(16) uint16_t delay[2][max_board_units][lockstep_lanes];
+    alignas(16) uint16_t poison[2][max_board_units][lockstep_lanes];  // skill value
+    alignas(16) uint16_t refresh[2][max_board_units][lockstep_lanes];  // skill value
+    alignas(16) uint16_t poisoned[2][max_board_units][lockstep_lanes];
+    alignas(16) uint16_t commander_hp[2][lockstep_lanes];
+    alignas(16) uint16_t num_assaults[2][lockstep_lanes];
+    alignas(16) uint16_t running[lockstep_lanes];  // 0xffff while the battle of the lane goes on
+    std::vector<const Card*> draws[2][lockstep_lanes];  // the cards each side plays, in order
+    unsigned next_draw[2][lockstep_lanes];
+
+    LockstepBoard();
+};
+
+// Whether play_lockstep() can play any battle of fd in lanes.
+bool lockstep_field_supported(const Field* fd);
+// Plays the next lockstep_lanes battles of fd, as many calls of (resets of the
+// hands and of fd, play()) would; returns how many were played in lanes.
+unsigned play_lockstep(Field* fd, LockstepBoard& board, Results<uint64_t> (&results)[lockstep_lanes]);
+
+#endif
+
+#endif
@@ -0,0 +1,63 @@
+#include "profile.h"
+
+#ifdef TUO_PROFILE
+
+#include <iomanip>
+
+const std::string profile_phase_names[ProfilePhase::num_phases] =
+{
+    "battle", "turn start", "play card", "BGE skills", "commander", "structures", "assaults", "attack", "on death", "turn end",
+};
+
+//------------------------------------------------------------------------------
+BattleProfile& BattleProfile::operator+=(const BattleProfile& other)
+{
+    for (unsigned i(0); i < ProfilePhase::num_phases; ++ i)
+    {
+        phases[i].calls += other.phases[i].calls;
+        phases[i].cycles += other.phases[i].cycles;
+    }
+    for (unsigned i(0); i < Skill::num_skills; ++ i)
+    {
+        skills[i].calls += other.skills[i].calls;
+        skills[i].cycles += other.skills[i].cycles;
+    }
+    return(*this);
+}
+//------------------------------------------------------------------------------
+void print_profile_header(std::ostream& os, const std::string& title)
+{
+    os << std::setw(12) << std::left << title << std::right
+        << std::setw(14) << "calls" << std::setw(18) << "cycles" << std::setw(14) << "cycles/battle" << "\n";
+}
+//------------------------------------------------------------------------------
+void print_profile_line(std::ostream& os, const std::string& name, const ProfileCounter& counter, uint64_t battles)
+{
+    os << std::setw(12) << std::left << name << std::right
+        << std::setw(14) << counter.calls
+        << std::setw(18) << counter.cycles
+        << std::setw(14) << std::fixed << std::setprecision(1) << (long double)counter.cycles / battles << "\n";
+}
+//------------------------------------------------------------------------------
+void BattleProfile::print(std::ostream& os) const
+{
+    uint64_t battles = phases[ProfilePhase::battle].calls;
+    if (battles == 0)
+    {
+        return;
+    }
+    os << "Profile of " << battles << " battles (inclusive cycles):\n";
+    print_profile_header(os, "phase");
+    for (unsigned i(0); i < ProfilePhase::num_phases; ++ i)
+    {
+        print_profile_line(os, profile_phase_names[i], phases[i], battles);
+    }
+    print_profile_header(os, "skill");
+    for (unsigned i(0); i < Skill::num_skills; ++ i)
+    {
+        if (skills[i].calls == 0) { continue; }
+        print_profile_line(os, skill_names[i], skills[i], battles);
+    }
+}
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef PROFILE_H_INCLUDED
+#define PROFILE_H_INCLUDED
+
+//---------------------- Battle profiler ---------------------------------------
+// Build with -DTUO_PROFILE to count the calls of, and the cycles spent in, each
+// phase of play() and each skill_table handler. The counters live in the Field,
+// so every thread has its own; the Process adds them up and prints the report
+// when it is destroyed. Timings are inclusive: e.g. the attacks and the
+// on-death skills are also part of the assaults phase. The structures and
+// assaults phases count one call per unit evaluated.
+// Without TUO_PROFILE the macros expand to nothing.
+#ifdef TUO_PROFILE
+
+#include <cstdint>
+#include <ostream>
+#include "tyrant.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+inline uint64_t profile_cycles() { return(__rdtsc()); }
+#else
+#include <chrono>
+// no cycle counter: nanoseconds
+inline uint64_t profile_cycles() { return(std::chrono::steady_clock::now().time_since_epoch().count()); }
+#endif
+
+namespace ProfilePhase {
+enum ProfilePhase
+{
+    battle,
+    turn_start,
+    play_card,
+    bge_skills,
+    commander,
+    structures,
+    assaults,
+    attack,
+    on_death,
+    turn_end,
+    num_phases
+};
+}
+extern const std::string profile_phase_names[ProfilePhase::num_phases];
+
+struct ProfileCounter
+{
+    uint64_t calls;
+    uint64_t cycles;
+};
+
+struct BattleProfile
+{
+    ProfileCounter phases[ProfilePhase::num_phases];
+    ProfileCounter skills[Skill::num_skills];
+
+    BattleProfile() :
+        phases(),
+        skills()
+    {
+    }
+
+    BattleProfile& operator+=(const BattleProfile& other);
+    void print(std::ostream& os) const;
+};
+
+class ProfileScope
+{
+public:
+    ProfileScope(ProfileCounter& counter_) :
+        counter(counter_),
+        start(profile_cycles())
+    {
+    }
+
+    ~ProfileScope()
+    {
+        ++ counter.calls;
+        counter.cycles += profile_cycles() - start;
+    }
+
+private:
+    ProfileCounter& counter;
+    uint64_t start;
+};
+
+#define TUO_PROFILE_PHASE(fd, phase) ProfileScope profile_phase_scope((fd)->profile.phases[ProfilePhase::phase])
+#define TUO_PROFILE_SKILL(fd, skill_id) ProfileScope profile_skill_scope((fd)->profile.skills[skill_id])
+
+#else
+
+#define TUO_PROFILE_PHASE(fd, phase)
+#define TUO_PROFILE_SKILL(fd, skill_id)
+
+#endif
+
+#endif
@@ -0,0 +1,252 @@
+#include "result_cache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/interprocess/sync/file_lock.hpp>
+#include <boost/interprocess/sync/scoped_lock.hpp>
+#include <boost/interprocess/sync/sharable_lock.hpp>
+
+//------------------------------------------------------------------------------
+void Hash128::add(const std::string& value)
+{
+    add(value.size());
+    for (size_t offset = 0; offset < value.size(); offset += sizeof(uint64_t))
+    {
+        uint64_t word(0);
+        memcpy(&word, value.data() + offset, std::min(sizeof(uint64_t), value.size() - offset));
+        add(word);
+    }
+}
+
+bool Hash128::add_file(const std::string& filename)
+{
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open())
+    {
+        return false;
+    }
+    std::stringstream content;
+    content << file.rdbuf();
+    add(content.str());
+    return true;
+}
+
+//------------------------------------------------------------------------------
+std::pair<EvaluatedResults*, bool> EvaluatedDecks::insert(const DeckFingerprint& fingerprint)
+{
+    size_t slot = find_slot(fingerprint);
+    if (slots[slot] != empty_slot)
+    {
+        return {&entries[slots[slot]].second, false};
+    }
+    if (2 * (entries.size() + 1) > slots.size())
+    {
+        grow();
+        slot = find_slot(fingerprint);
+    }
+    const EvaluatedResults* cached_results = cached ? cached->find(fingerprint) : nullptr;
+    slots[slot] = entries.size();
+    entries.emplace_back(fingerprint, cached_results ? *cached_results : zero_results);
+    if (cached_results)
+    {
+        num_cached_simulations += cached_results->second;
+    }
+    return {&entries.back().second, cached_results == nullptr};
+}
+
+const EvaluatedResults* EvaluatedDecks::find(const DeckFingerprint& fingerprint) const
+{
+    size_t slot = find_slot(fingerprint);
+    return slots[slot] == empty_slot ? nullptr : &entries[slots[slot]].second;
+}
+
+size_t EvaluatedDecks::find_slot(const DeckFingerprint& fingerprint) const
+{
+    const size_t mask = slots.size() - 1;
+    size_t slot = fingerprint.low & mask;
+    while (slots[slot] != empty_slot && !(entries[slots[slot]].first == fingerprint))
+    {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+void EvaluatedDecks::grow()
+{
+    slots.assign(slots.size() * 2, empty_slot);
+    for (unsigned index(0); index < entries.size(); ++index)
+    {
+        slots[find_slot(entries[index].first)] = index;
+    }
+}
+
+const unsigned EvaluatedDecks::empty_slot;
+
+//------------------------------------------------------------------------------
+// A record is a header followed by num_results Results<int64_t>, in native
+// byte order; its size is a multiple of 8 bytes.
+struct ResultCacheHeader
+{
+    uint32_t magic;
+    uint32_t num_results;
+    uint64_t context_low;
+    uint64_t context_high;
+    uint64_t deck_low;
+    uint64_t deck_high;
+    uint64_t iterations;
+    uint64_t checksum;  // of the fields above and the results
+};
+const uint32_t result_cache_magic = 0x31435554;  // "TUC1"
+
+uint64_t record_checksum(const ResultCacheHeader& header, const Results<int64_t>* results)
+{
+    Hash128 hash;
+    hash.add(((uint64_t)header.magic << 32) | header.num_results);
+    hash.add(header.context_low);
+    hash.add(header.context_high);
+    hash.add(header.deck_low);
+    hash.add(header.deck_high);
+    hash.add(header.iterations);
+    for (unsigned index(0); index < header.num_results; ++index)
+    {
+        hash.add(results[index].wins);
+        hash.add(results[index].draws);
+        hash.add(results[index].losses);
+        hash.add(results[index].points);
+    }
+    return hash.low;
+}
+
+//------------------------------------------------------------------------------
+ResultCache::ResultCache(const std::string& filename_, const Hash128& context_, unsigned num_results_) :
+    filename(filename_),
+    context(context_),
+    num_results(num_results_),
+    cached({std::vector<Results<int64_t>>(num_results_), 0})
+{
+    namespace bip = boost::interprocess;
+    {
+        // create the file if needed: the lock and the mapping need one
+        std::ofstream file(filename, std::ios::binary | std::ios::app);
+        if (!file.is_open())
+        {
+            throw std::runtime_error("cannot open the file");
+        }
+    }
+    try
+    {
+        bip::file_lock lock(filename.c_str());
+        bip::sharable_lock<bip::file_lock> read_lock(lock);
+        uintmax_t size = boost::filesystem::file_size(filename);
+        if (size == 0)
+        {
+            return;
+        }
+        bip::file_mapping mapping(filename.c_str(), bip::read_only);
+        bip::mapped_region region(mapping, bip::read_only);
+        const char* data = static_cast<const char*>(region.get_address());
+        std::vector<Results<int64_t>> results;
+        for (uintmax_t offset = 0; offset + sizeof(ResultCacheHeader) <= size; )
+        {
+            ResultCacheHeader header;
+            memcpy(&header, data + offset, sizeof(header));
+            uintmax_t record_size = sizeof(header) + (uintmax_t)header.num_results * sizeof(Results<int64_t>);
+            if (header.magic != result_cache_magic || offset + record_size > size)
+            {
+                // not the start of a record (torn by a crash): look for the next one
+                offset += sizeof(uint64_t);
+                continue;
+            }
+            results.resize(header.num_results);
+            memcpy(results.data(), data + offset + sizeof(header), header.num_results * sizeof(Results<int64_t>));
+            if (header.checksum != record_checksum(header, results.data()))
+            {
+                offset += sizeof(uint64_t);
+                continue;
+            }
+            offset += record_size;
+            if (header.context_low != context.low || header.context_high != context.high || header.num_results != num_results)
+            {
+                continue;
+            }
+            DeckFingerprint deck;
+            deck.low = header.deck_low;
+            deck.high = header.deck_high;
+            EvaluatedResults& deck_results = cached[deck];
+            for (unsigned index(0); index < num_results; ++index)
+            {
+                deck_results.first[index] += results[index];
+            }
+            deck_results.second += header.iterations;
+        }
+    }
+    catch (const bip::interprocess_exception& e)
+    {
+        throw std::runtime_error(e.what());
+    }
+}
+
+unsigned ResultCache::append(const EvaluatedDecks& evaluated)
+{
+    namespace bip = boost::interprocess;
+    std::string records;
+    unsigned num_records(0);
+    std::vector<Results<int64_t>> results(num_results);
+    for (const auto & entry: evaluated)
+    {
+        EvaluatedResults& deck_results = cached[entry.first];
+        if (entry.second.second <= deck_results.second)
+        {
+            continue;
+        }
+        ResultCacheHeader header;
+        header.magic = result_cache_magic;
+        header.num_results = num_results;
+        header.context_low = context.low;
+        header.context_high = context.high;
+        header.deck_low = entry.first.low;
+        header.deck_high = entry.first.high;
+        header.iterations = entry.second.second - deck_results.second;
+        for (unsigned index(0); index < num_results; ++index)
+        {
+            const Results<int64_t>& total = entry.second.first[index];
+            const Results<int64_t>& old = deck_results.first[index];
+            results[index] = {total.wins - old.wins, total.draws - old.draws, total.losses - old.losses, total.points - old.points};
+        }
+        header.checksum = record_checksum(header, results.data());
+        records.append(reinterpret_cast<const char*>(&header), sizeof(header));
+        records.append(reinterpret_cast<const char*>(results.data()), num_results * sizeof(Results<int64_t>));
+        deck_results = entry.second;
+        ++ num_records;
+    }
+    if (records.empty())
+    {
+        return 0;
+    }
+    try
+    {
+        bip::file_lock lock(filename.c_str());
+        bip::scoped_lock<bip::file_lock> write_lock(lock);
+        std::ofstream file(filename, std::ios::binary | std::ios::app);
+        // a record torn by a crash may have left the end unaligned
+        uintmax_t size = boost::filesystem::file_size(filename);
+        records.insert(0, (sizeof(uint64_t) - size % sizeof(uint64_t)) % sizeof(uint64_t), '\0');
+        file.write(records.data(), records.size());
+        file.close();
+        if (!file)
+        {
+            throw std::runtime_error("cannot write to the file");
+        }
+    }
+    catch (const bip::interprocess_exception& e)
+    {
+        throw std::runtime_error(e.what());
+    }
+    return num_records;
+}
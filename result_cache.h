@@ -0,0 +1,94 @@
+#ifndef RESULT_CACHE_H_INCLUDED
+#define RESULT_CACHE_H_INCLUDED
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+#include "deck.h"
+#include "sim.h"
+
+//------------------------------------------------------------------------------
+// 128-bit hash of a sequence of values (not cryptographic).
+struct Hash128
+{
+    uint64_t low{0};
+    uint64_t high{0};
+
+    void add(uint64_t value)
+    {
+        low = fingerprint_mix(low ^ value);
+        high = fingerprint_mix((high ^ value) + 0x632be59bd9b4e019ULL);
+    }
+    void add(const std::string& value);
+    // false if the file cannot be read
+    bool add_file(const std::string& filename);
+    bool operator==(const Hash128& other) const { return low == other.low && high == other.high; }
+};
+
+//---------------------- Decks evaluated by a climb ----------------------------
+// By fingerprint: open addressing with linear probing. The results are kept in
+// a deque, so that references to them stay valid when the table grows. A deck
+// added to the table starts from its results in `cached`, if any.
+class EvaluatedDecks
+{
+public:
+    typedef std::pair<DeckFingerprint, EvaluatedResults> Entry;
+
+    explicit EvaluatedDecks(const EvaluatedResults& zero_results_, const EvaluatedDecks* cached_ = nullptr) :
+        zero_results(zero_results_),
+        cached(cached_),
+        slots(64, empty_slot)
+    {
+    }
+
+    // Results of the deck; second: whether it was added with zero results.
+    std::pair<EvaluatedResults*, bool> insert(const DeckFingerprint& fingerprint);
+    EvaluatedResults& operator[](const DeckFingerprint& fingerprint) { return *insert(fingerprint).first; }
+    const EvaluatedResults* find(const DeckFingerprint& fingerprint) const;
+    size_t size() const { return entries.size(); }
+    // battles taken from `cached`
+    unsigned long cached_simulations() const { return num_cached_simulations; }
+    std::deque<Entry>::const_iterator begin() const { return entries.begin(); }
+    std::deque<Entry>::const_iterator end() const { return entries.end(); }
+
+private:
+    static const unsigned empty_slot = ~0u;
+    const EvaluatedResults zero_results;
+    const EvaluatedDecks* cached;
+    unsigned long num_cached_simulations{0};
+    std::deque<Entry> entries;
+    std::vector<unsigned> slots;  // index in entries; the size is a power of 2
+
+    // slot of the fingerprint, or the empty slot where it would go
+    size_t find_slot(const DeckFingerprint& fingerprint) const;
+    void grow();
+};
+
+//---------------------- Result cache on disk ----------------------------------
+// Opt-in (cache <file>): the results of the decks evaluated by the climbs, kept
+// across runs. The file is a sequence of records that is only ever appended to:
+// each one holds the battles a run added to one deck in one context (the enemy
+// decks and everything else the battles depend on), and the results of a deck
+// are the sum of its records. The file is read through a memory mapping under a
+// shared file lock and appended to under an exclusive one, so that concurrent
+// runs can share it; records torn by a crash are skipped.
+class ResultCache
+{
+public:
+    // Reads the records of the context; throws std::runtime_error if the file cannot be used.
+    ResultCache(const std::string& filename_, const Hash128& context_, unsigned num_results_);
+
+    const EvaluatedDecks& results() const { return cached; }
+    // Appends the battles that the decks got since they were read (or last appended); returns the number of decks.
+    unsigned append(const EvaluatedDecks& evaluated);
+
+private:
+    const std::string filename;
+    const Hash128 context;
+    const unsigned num_results;
+    EvaluatedDecks cached;
+};
+
+#endif
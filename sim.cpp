@@ -37,11 +37,12 @@ template <typename CardsIter, typename Functor>
 inline unsigned Field::make_selection_array(CardsIter first, CardsIter last, Functor f)
 {
     this->selection_array.clear();
-    for(auto c = first; c != last; ++c)
+    for(auto it = first; it != last; ++it)
     {
-        if (f(*c))
+        CardStatus* c = &*it;
+        if (f(c))
         {
-            this->selection_array.push_back(*c);
+            this->selection_array.push_back(c);
         }
     }
     return(this->selection_array.size());
@@ -80,13 +81,14 @@ inline CardStatus * Field::right_assault(const CardStatus * status, const unsign
     }
     return nullptr;
 }
-inline const std::vector<CardStatus *> Field::adjacent_assaults(const CardStatus * status)
+inline const AdjacentAssaults Field::adjacent_assaults(const CardStatus * status)
 {
     return adjacent_assaults(status, 1);
 }
-inline const std::vector<CardStatus *> Field::adjacent_assaults(const CardStatus * status, const unsigned n)
+inline const AdjacentAssaults Field::adjacent_assaults(const CardStatus * status, const unsigned n)
 {
-    std::vector<CardStatus *> res;
+    assert(n <= 2);
+    AdjacentAssaults res;
     for (unsigned i(n); i > 0; -- i)
     {
         auto left_status = left_assault(status, i);
@@ -114,34 +116,79 @@ inline void Field::print_selection_array()
 //------------------------------------------------------------------------------
 inline void Field::prepare_action()
 {
-    damaged_units_to_times.clear();
+    ++ action_index;
+    damaged_units.clear();
 }
 
 //------------------------------------------------------------------------------
 inline void Field::finalize_action()
 {
-    for (auto unit_it = damaged_units_to_times.begin(); unit_it != damaged_units_to_times.end(); ++ unit_it)
+    for (CardStatus * dmg_status: damaged_units)
     {
-        if (__builtin_expect(!unit_it->second, false))
-        { continue; }
-        CardStatus * dmg_status = unit_it->first;
         if (__builtin_expect(!is_alive(dmg_status), false))
         { continue; }
         unsigned barrier_base = dmg_status->skill(Skill::barrier);
         if (barrier_base)
         {
-            unsigned protect_value = barrier_base * unit_it->second;
+            unsigned protect_value = barrier_base * dmg_status->m_damaged_times;
             _DEBUG_MSG(1, "%s protect itself for %u (barrier %u x %u damage taken times)\n",
-                status_description(dmg_status).c_str(), protect_value, barrier_base, unit_it->second);
+                status_description(dmg_status).c_str(), protect_value, barrier_base, dmg_status->m_damaged_times);
             dmg_status->m_protected += protect_value;
         }
     }
 }
 
+//------------------------------------------------------------------------------
+inline unsigned CardStatus::skill_slot(Skill::Skill skill_id) const
+{
+    unsigned slot = m_card->m_skill_slot[skill_id];
+    if (slot == 0)
+    {
+        for (unsigned i(0); i < m_num_extra_skills; ++ i)
+        {
+            if (m_extra_skill_ids[i] == skill_id) { return m_card->m_num_skill_slots + 1 + i; }
+        }
+    }
+    return slot;
+}
+//------------------------------------------------------------------------------
+unsigned CardStatus::track_skill(Skill::Skill skill_id)
+{
+    unsigned slot = skill_slot(skill_id);
+    if (slot == 0)
+    {
+        slot = m_card->m_num_skill_slots + 1 + m_num_extra_skills;
+        assert(slot < max_skill_slots);
+        m_extra_skill_ids[m_num_extra_skills ++] = skill_id;
+        m_primary_skill_offset[slot] = 0;
+        m_evolved_skill_offset[slot] = 0;
+        m_enhanced_value[slot] = 0;
+        m_skill_cd[slot] = 0;
+    }
+    return slot;
+}
+//------------------------------------------------------------------------------
+// Undo evolve and enhance; cooldowns of the card's own skills are kept.
+void CardStatus::reset_skill_slots()
+{
+    for (unsigned slot(1), end(m_card->m_num_skill_slots + 1); slot < end; ++ slot)
+    {
+        m_primary_skill_offset[slot] = 0;
+        m_evolved_skill_offset[slot] = 0;
+        m_enhanced_value[slot] = 0;
+    }
+    m_num_extra_skills = 0;
+    m_skills_modified = false;
+}
+//------------------------------------------------------------------------------
+inline Skill::Skill CardStatus::primary_skill(Skill::Skill skill_id) const
+{
+    return static_cast<Skill::Skill>(skill_id + m_primary_skill_offset[skill_slot(skill_id)]);
+}
 //------------------------------------------------------------------------------
 inline unsigned CardStatus::skill_base_value(Skill::Skill skill_id) const
 {
-    return m_card->m_skill_value[skill_id + m_primary_skill_offset[skill_id]]
+    return m_card->m_skill_value[primary_skill(skill_id)]
             + (skill_id == Skill::berserk ? m_enraged : 0);
 }
 //------------------------------------------------------------------------------
@@ -160,7 +207,7 @@ inline bool CardStatus::has_skill(Skill::Skill skill_id) const
 //------------------------------------------------------------------------------
 inline unsigned CardStatus::enhanced(Skill::Skill skill_id) const
 {
-    return m_enhanced_value[skill_id + m_primary_skill_offset[skill_id]];
+    return m_enhanced_value[skill_slot(primary_skill(skill_id))];
 }
 //------------------------------------------------------------------------------
 inline unsigned CardStatus::protected_value() const
@@ -202,11 +249,18 @@ inline void CardStatus::set(const Card& card)
     m_rush_attempted = false;
     m_sundered = false;
     m_weakened = 0;
+    m_damaged_times = 0;
+    m_damaged_action = 0;
 
-    std::memset(m_primary_skill_offset, 0, sizeof m_primary_skill_offset);
-    std::memset(m_evolved_skill_offset, 0, sizeof m_evolved_skill_offset);
-    std::memset(m_enhanced_value, 0, sizeof m_enhanced_value);
-    std::memset(m_skill_cd, 0, sizeof m_skill_cd);
+    m_skills_modified = false;
+    m_num_extra_skills = 0;
+    for (unsigned slot(0), end(card.m_num_skill_slots + 1); slot < end; ++ slot)
+    {
+        m_primary_skill_offset[slot] = 0;
+        m_evolved_skill_offset[slot] = 0;
+        m_enhanced_value[slot] = 0;
+        m_skill_cd[slot] = 0;
+    }
 }
 //------------------------------------------------------------------------------
 inline unsigned attack_power(const CardStatus* att)
@@ -310,26 +364,73 @@ std::string CardStatus::description() const
     for (const auto & ss: m_card->m_skills)
     {
         std::string skill_desc;
-        if (m_evolved_skill_offset[ss.id] != 0) { skill_desc += "->" + skill_names[ss.id + m_evolved_skill_offset[ss.id]]; }
-        if (m_enhanced_value[ss.id] != 0) { skill_desc += " +" + to_string(m_enhanced_value[ss.id]); }
+        unsigned slot = skill_slot(ss.id);
+        if (m_evolved_skill_offset[slot] != 0) { skill_desc += "->" + skill_names[ss.id + m_evolved_skill_offset[slot]]; }
+        if (m_enhanced_value[slot] != 0) { skill_desc += " +" + to_string(m_enhanced_value[slot]); }
         if (!skill_desc.empty()) { desc += ", " + skill_names[ss.id] + skill_desc; }
     }
     desc += "]";
     return(desc);
 }
 //------------------------------------------------------------------------------
-void Hand::reset(std::mt19937& re)
+void Hand::reset(RandomEngine& re)
 {
     assaults.reset();
     structures.reset();
     deck->shuffle(re);
     commander.set(deck->shuffled_commander);
     total_cards_destroyed = 0;
+    std::fill(alive_faction_count, alive_faction_count + num_factions, 0u);
+    alive_factions_bitmap = 0;
+    alive_walls_mask = 0;
     if (commander.skill(Skill::stasis))
     {
         stasis_faction_bitmap |= (1u << commander.m_faction);
     }
 }
+//------------------------------------------------------------------------------
+inline void Hand::count_alive(const CardStatus* status)
+{
+    if (status->m_card->m_type == CardType::assault)
+    {
+        Faction faction = status->m_card->m_faction;
+        ++ alive_faction_count[faction];
+        alive_factions_bitmap |= (1u << faction);
+    }
+    else if (status->has_skill(Skill::wall))
+    {
+        alive_walls_mask |= (uint64_t(1) << status->m_index);
+    }
+}
+//------------------------------------------------------------------------------
+inline void Hand::count_dead(const CardStatus* status)
+{
+    if (status->m_card->m_type == CardType::assault)
+    {
+        Faction faction = status->m_card->m_faction;
+        if (-- alive_faction_count[faction] == 0)
+        {
+            alive_factions_bitmap &= ~(1u << faction);
+        }
+    }
+    else
+    {
+        alive_walls_mask &= ~(uint64_t(1) << status->m_index);
+    }
+}
+//------------------------------------------------------------------------------
+// remove_dead() shifted the structures: rebuild the mask from their new indices
+inline void Hand::recount_walls()
+{
+    alive_walls_mask = 0;
+    for (unsigned index(0), end(structures.size()); index < end; ++ index)
+    {
+        if (structures[index].has_skill(Skill::wall))
+        {
+            alive_walls_mask |= (uint64_t(1) << index);
+        }
+    }
+}
 //---------------------- $40 Game rules implementation -------------------------
 // Everything about how a battle plays out, except the following:
 // the implementation of the attack by an assault card is in the next section;
@@ -368,7 +469,9 @@ void prepend_on_death(Field* fd)
     {
         return;
     }
-    std::vector<std::tuple<CardStatus*, SkillSpec>> od_skills;
+    TUO_PROFILE_PHASE(fd, on_death);
+    // On death skills are queued at the back, then moved to the front of the queue.
+    auto num_queued_skills = fd->skill_queue.size();
     auto & assaults = fd->players[fd->killed_units[0]->m_player]->assaults;
     unsigned stacked_poison_value = 0;
     unsigned last_index = 99;
@@ -391,7 +494,7 @@ void prepend_on_death(Field* fd)
                 }
             }
             // Virulence
-            if (fd->bg_effects.count(PassiveBGE::virulence))
+            if (fd->has_bg_effect(PassiveBGE::virulence))
             {
                 if (status->m_index != last_index + 1)
                 {
@@ -433,29 +536,33 @@ void prepend_on_death(Field* fd)
             }
         }
         // Revenge
-        if (fd->bg_effects.count(PassiveBGE::revenge))
+        if (fd->has_bg_effect(PassiveBGE::revenge))
         {
-            SkillSpec ss_heal{Skill::heal, fd->bg_effects.at(PassiveBGE::revenge), allfactions, 0, 0, Skill::no_skill, Skill::no_skill, true,};
-            SkillSpec ss_rally{Skill::rally, fd->bg_effects.at(PassiveBGE::revenge), allfactions, 0, 0, Skill::no_skill, Skill::no_skill, true,};
+            const SkillSpec & ss_heal = fd->revenge_skills[0];
+            const SkillSpec & ss_rally = fd->revenge_skills[1];
             CardStatus * commander = &fd->players[status->m_player]->commander;
             _DEBUG_MSG(2, "Revenge: Preparing skill %s and %s\n",
                 skill_description(ss_heal).c_str(), skill_description(ss_rally).c_str());
-            od_skills.emplace_back(commander, ss_heal);
-            od_skills.emplace_back(commander, ss_rally);
+            fd->skill_queue.push_back({commander, &ss_heal});
+            fd->skill_queue.push_back({commander, &ss_rally});
         }
     }
-    fd->skill_queue.insert(fd->skill_queue.begin(), od_skills.begin(), od_skills.end());
+    fd->skill_queue.move_back_to_front(fd->skill_queue.size() - num_queued_skills);
     fd->killed_units.clear();
 }
 //------------------------------------------------------------------------------
-void(*skill_table[Skill::num_skills])(Field*, CardStatus* src, const SkillSpec&);
+typedef void(*SkillFunction)(Field*, CardStatus* src, const SkillSpec&);
+// Skill handlers of the play variants without and with quest counting.
+SkillFunction skill_table[Skill::num_skills];
+SkillFunction quest_skill_table[Skill::num_skills];
+template<bool quest>
 void resolve_skill(Field* fd)
 {
     while(!fd->skill_queue.empty())
     {
         auto skill_instance(fd->skill_queue.front());
-        auto& status(std::get<0>(skill_instance));
-        const auto& ss(std::get<1>(skill_instance));
+        auto& status(skill_instance.first);
+        const auto& ss(*skill_instance.second);
         fd->skill_queue.pop_front();
         if (!is_alive(status))
         {
@@ -472,7 +579,7 @@ void resolve_skill(Field* fd)
         SkillSpec modified_s = ss;
 
         // apply evolve
-        signed evolved_offset = status->m_evolved_skill_offset[modified_s.id];
+        signed evolved_offset = status->m_evolved_skill_offset[status->skill_slot(modified_s.id)];
         if (evolved_offset != 0)
         { modified_s = apply_evolve(modified_s, evolved_offset); }
 
@@ -493,19 +600,21 @@ void resolve_skill(Field* fd)
                 status_description(status).c_str(), skill_description(ss).c_str());
             continue;
         }
-        else { skill_table[modified_s.id](fd, status, modified_s); }
+        else
+        {
+            TUO_PROFILE_SKILL(fd, modified_s.id);
+            (quest ? quest_skill_table : skill_table)[modified_s.id](fd, status, modified_s);
+        }
     }
 }
 //------------------------------------------------------------------------------
+template<bool quest>
 bool attack_phase(Field* fd);
-template<Skill::Skill skill_id>
-bool check_and_perform_skill(Field* fd, CardStatus* src, CardStatus* dst, const SkillSpec& s, bool is_evadable
-#ifndef NQUEST
-    , bool & has_counted_quest
-#endif
-);
+template<Skill::Skill skill_id, bool quest>
+bool check_and_perform_skill(Field* fd, CardStatus* src, CardStatus* dst, const SkillSpec& s, bool is_evadable, bool & has_counted_quest);
+template<bool quest>
 bool check_and_perform_valor(Field* fd, CardStatus* src);
-template <enum CardType::CardType type>
+template <enum CardType::CardType type, bool quest>
 void evaluate_skills(Field* fd, CardStatus* status, const std::vector<SkillSpec>& skills, bool* attacked=nullptr)
 {
     assert(status);
@@ -514,21 +623,17 @@ void evaluate_skills(Field* fd, CardStatus* status, const std::vector<SkillSpec>
     {
         fd->prepare_action();
         assert(fd->skill_queue.size() == 0);
+        // activation skills only, assuming activation skills can be evolved from only activation skills
         for (auto & ss: skills)
         {
-            // check if activation skill, assuming activation skills can be evolved from only activation skills
-            if (skill_table[ss.id] == nullptr)
-            {
-                continue;
-            }
-            if (status->m_skill_cd[ss.id] > 0)
+            if (status->m_skill_cd[status->skill_slot(ss.id)] > 0)
             {
                 continue;
             }
             _DEBUG_MSG(2, "Evaluating %s skill %s\n",
                 status_description(status).c_str(), skill_description(ss).c_str());
-            fd->skill_queue.emplace_back(status, ss);
-            resolve_skill(fd);
+            fd->skill_queue.push_back({status, &ss});
+            resolve_skill<quest>(fd);
             if(__builtin_expect(fd->end, false)) { break; }
         }
         if (type == CardType::assault)
@@ -536,7 +641,7 @@ void evaluate_skills(Field* fd, CardStatus* status, const std::vector<SkillSpec>
             // Attack
             if (can_act(status))
             {
-                if (attack_phase(fd) && !*attacked)
+                if (attack_phase<quest>(fd) && !*attacked)
                 {
                     *attacked = true;
                     if (__builtin_expect(fd->end, false)) { break; }
@@ -549,23 +654,21 @@ void evaluate_skills(Field* fd, CardStatus* status, const std::vector<SkillSpec>
         }
         fd->finalize_action();
         // Flurry
-        if (can_act(status) && is_alive(&fd->tip->commander) && status->has_skill(Skill::flurry) && status->m_skill_cd[Skill::flurry] == 0)
+        if (can_act(status) && is_alive(&fd->tip->commander) && status->has_skill(Skill::flurry) && status->m_skill_cd[status->skill_slot(Skill::flurry)] == 0)
         {
-#ifndef NQUEST
-            if (status->m_player == 0)
+            if (quest && status->m_player == 0)
             {
                 fd->inc_counter(QuestType::skill_use, Skill::flurry);
             }
-#endif
             _DEBUG_MSG(1, "%s activates Flurry x %d\n",
                 status_description(status).c_str(), status->skill_base_value(Skill::flurry));
             num_actions += status->skill_base_value(Skill::flurry);
-            for (const auto & ss : skills)
+            for (const auto & ss : status->m_card->m_skills)
             {
-                Skill::Skill evolved_skill_id = static_cast<Skill::Skill>(ss.id + status->m_evolved_skill_offset[ss.id]);
+                Skill::Skill evolved_skill_id = static_cast<Skill::Skill>(ss.id + status->m_evolved_skill_offset[status->skill_slot(ss.id)]);
                 if (evolved_skill_id == Skill::flurry)
                 {
-                    status->m_skill_cd[ss.id] = ss.c;
+                    status->m_skill_cd[status->skill_slot(ss.id)] = ss.c;
                 }
             }
         }
@@ -586,11 +689,11 @@ struct PlayCard
         storage{nullptr}
     {}
 
-    template <enum CardType::CardType type>
+    template <enum CardType::CardType type, bool quest>
     CardStatus* op()
     {
         setStorage<type>();
-        placeCard<type>();
+        placeCard<type, quest>();
         return(status);
     }
 
@@ -599,15 +702,15 @@ struct PlayCard
     {
     }
 
-    template <enum CardType::CardType type>
+    template <enum CardType::CardType type, bool quest>
     void placeCard()
     {
         status = &storage->add_back();
         status->set(card);
         status->m_index = storage->size() - 1;
         status->m_player = fd->tapi;
-#ifndef NQUEST
-        if (status->m_player == 0)
+        fd->tap->count_alive(status);
+        if (quest && status->m_player == 0)
         {
             if (status->m_card->m_type == CardType::assault)
             {
@@ -615,13 +718,12 @@ struct PlayCard
             }
             fd->inc_counter(QuestType::type_card_use, type);
         }
-#endif
         _DEBUG_MSG(1, "%s plays %s %u [%s]\n",
             status_description(&fd->tap->commander).c_str(), cardtype_names[type].c_str(),
             static_cast<unsigned>(storage->size() - 1), card_description(fd->cards, card).c_str());
         if (status->m_delay == 0)
         {
-            check_and_perform_valor(fd, status);
+            check_and_perform_valor<quest>(fd, status);
         }
     }
 };
@@ -691,6 +793,7 @@ inline bool skill_check<Skill::drain>(Field* fd, CardStatus* c, CardStatus* ref)
     return(can_be_healed(c));
 }
 
+template<bool quest>
 void remove_hp(Field* fd, CardStatus* status, unsigned dmg)
 {
     if (__builtin_expect(!dmg, false)) { return; }
@@ -699,14 +802,19 @@ void remove_hp(Field* fd, CardStatus* status, unsigned dmg)
     status->m_hp = safe_minus(status->m_hp, dmg);
     if (fd->current_phase < Field::end_phase && status->has_skill(Skill::barrier))
     {
-        ++ fd->damaged_units_to_times[status];
+        if (status->m_damaged_action != fd->action_index)
+        {
+            status->m_damaged_action = fd->action_index;
+            status->m_damaged_times = 0;
+            fd->damaged_units.push_back(status);
+        }
+        ++ status->m_damaged_times;
         _DEBUG_MSG(2, "%s damaged %u times\n",
-            status_description(status).c_str(), fd->damaged_units_to_times[status]);
+            status_description(status).c_str(), status->m_damaged_times);
     }
     if (status->m_hp == 0)
     {
-#ifndef NQUEST
-        if (status->m_player == 1)
+        if (quest && status->m_player == 1)
         {
             if (status->m_card->m_type == CardType::assault)
             {
@@ -714,12 +822,12 @@ void remove_hp(Field* fd, CardStatus* status, unsigned dmg)
             }
             fd->inc_counter(QuestType::type_card_kill, status->m_card->m_type);
         }
-#endif
         _DEBUG_MSG(1, "%s dies\n", status_description(status).c_str());
         if(status->m_card->m_type != CardType::commander)
         {
             fd->killed_units.push_back(status);
             ++ fd->players[status->m_player]->total_cards_destroyed;
+            fd->players[status->m_player]->count_dead(status);
         }
         if (status->m_player == 0 && fd->players[0]->deck->vip_cards.count(status->m_card->m_id))
         {
@@ -742,6 +850,16 @@ inline void remove_dead(Storage<CardStatus>& storage)
 {
     storage.remove(is_it_dead);
 }
+inline void remove_dead(Hand* hand)
+{
+    remove_dead(hand->assaults);
+    unsigned num_structures = hand->structures.size();
+    remove_dead(hand->structures);
+    if (hand->alive_walls_mask && hand->structures.size() != num_structures)
+    {
+        hand->recount_walls();
+    }
+}
 inline void add_hp(Field* fd, CardStatus* target, unsigned v)
 {
     target->m_hp = std::min(target->m_hp + v, target->m_max_hp);
@@ -750,16 +868,19 @@ void cooldown_skills(CardStatus * status)
 {
     for (const auto & ss : status->m_card->m_skills)
     {
-        if (status->m_skill_cd[ss.id] > 0)
+        unsigned slot = status->skill_slot(ss.id);
+        if (status->m_skill_cd[slot] > 0)
         {
             _DEBUG_MSG(2, "%s reduces timer (%u) of skill %s\n",
-                status_description(status).c_str(), status->m_skill_cd[ss.id], skill_names[ss.id].c_str());
-            -- status->m_skill_cd[ss.id];
+                status_description(status).c_str(), status->m_skill_cd[slot], skill_names[ss.id].c_str());
+            -- status->m_skill_cd[slot];
         }
     }
 }
+template<bool quest>
 void turn_start_phase(Field* fd)
 {
+    TUO_PROFILE_PHASE(fd, turn_start);
     // Active player's commander card:
     cooldown_skills(&fd->tap->commander);
     // Active player's assault cards:
@@ -779,7 +900,7 @@ void turn_start_phase(Field* fd)
                 -- status->m_delay;
                 if (status->m_delay == 0)
                 {
-                    check_and_perform_valor(fd, status);
+                    check_and_perform_valor<quest>(fd, status);
                 }
             }
             else
@@ -835,8 +956,10 @@ void turn_start_phase(Field* fd)
         }
     }
 }
+template<bool quest>
 void turn_end_phase(Field* fd)
 {
+    TUO_PROFILE_PHASE(fd, turn_end);
     // Inactive player's assault cards:
     {
         auto& assaults(fd->tip->assaults);
@@ -849,9 +972,10 @@ void turn_end_phase(Field* fd)
             }
             status.m_enfeebled = 0;
             status.m_protected = 0;
-            std::memset(status.m_primary_skill_offset, 0, sizeof status.m_primary_skill_offset);
-            std::memset(status.m_evolved_skill_offset, 0, sizeof status.m_evolved_skill_offset);
-            std::memset(status.m_enhanced_value, 0, sizeof status.m_enhanced_value);
+            if (status.m_skills_modified)
+            {
+                status.reset_skill_slots();
+            }
             status.m_evaded = 0;  // so far only useful in Inactive turn
             status.m_paybacked = 0;  // ditto
         }
@@ -891,14 +1015,12 @@ void turn_end_phase(Field* fd)
                 unsigned poison_dmg = safe_minus(status.m_poisoned + status.m_enfeebled, status.protected_value());
                 if (poison_dmg > 0)
                 {
-#ifndef NQUEST
-                    if (status.m_player == 1)
+                    if (quest && status.m_player == 1)
                     {
                         fd->inc_counter(QuestType::skill_damage, Skill::poison, 0, poison_dmg);
                     }
-#endif
                     _DEBUG_MSG(1, "%s takes poison damage %u\n", status_description(&status).c_str(), poison_dmg);
-                    remove_hp(fd, &status, poison_dmg);  // simultaneous
+                    remove_hp<quest>(fd, &status, poison_dmg);  // simultaneous
                 }
             }
             // end of the opponent's next turn for enemy units
@@ -918,11 +1040,9 @@ void turn_end_phase(Field* fd)
     // nothing so far
 
     prepend_on_death(fd);  // poison
-    resolve_skill(fd);
-    remove_dead(fd->tap->assaults);
-    remove_dead(fd->tap->structures);
-    remove_dead(fd->tip->assaults);
-    remove_dead(fd->tip->structures);
+    resolve_skill<quest>(fd);
+    remove_dead(fd->tap);
+    remove_dead(fd->tip);
 }
 //---------------------- $50 attack by assault card implementation -------------
 // Counter damage dealt to the attacker (att) by defender (def)
@@ -934,10 +1054,11 @@ inline unsigned counter_damage(Field* fd, CardStatus* att, CardStatus* def)
 }
 inline CardStatus* select_first_enemy_wall(Field* fd)
 {
-    for(unsigned i(0); i < fd->tip->structures.size(); ++i)
+    for(uint64_t walls_mask(fd->tip->alive_walls_mask); walls_mask; walls_mask &= walls_mask - 1)
     {
-        CardStatus& c(fd->tip->structures[i]);
-        if(c.has_skill(Skill::wall) && is_alive(&c) && skill_check<Skill::wall>(fd, &c, nullptr))
+        CardStatus& c(fd->tip->structures[__builtin_ctzll(walls_mask)]);
+        assert(c.has_skill(Skill::wall) && is_alive(&c));
+        if(skill_check<Skill::wall>(fd, &c, nullptr))
         {
             return(&c);
         }
@@ -976,7 +1097,7 @@ struct PerformAttack
         fd(fd_), att_status(att_status_), def_status(def_status_), att_dmg(0)
     {}
 
-    template<enum CardType::CardType def_cardtype>
+    template<enum CardType::CardType def_cardtype, bool quest>
     unsigned op()
     {
         unsigned pre_modifier_dmg = attack_power(att_status);
@@ -991,33 +1112,31 @@ struct PerformAttack
         modify_attack_damage<def_cardtype>(pre_modifier_dmg);
         if (att_dmg == 0) { return 0; }
 
-        attack_damage<def_cardtype>();
+        attack_damage<def_cardtype, quest>();
         if(__builtin_expect(fd->end, false)) { return att_dmg; }
-        damage_dependant_pre_oa<def_cardtype>();
+        damage_dependant_pre_oa<def_cardtype, quest>();
 
         // Enemy Skill: Counter
         if (def_status->has_skill(Skill::counter) && skill_check<Skill::counter>(fd, def_status, att_status))
         {
             // perform_skill_counter
             unsigned counter_dmg(counter_damage(fd, att_status, def_status));
-#ifndef NQUEST
-            if (def_status->m_player == 0)
+            if (quest && def_status->m_player == 0)
             {
                 fd->inc_counter(QuestType::skill_use, Skill::counter);
                 fd->inc_counter(QuestType::skill_damage, Skill::counter, 0, counter_dmg);
             }
-#endif
             _DEBUG_MSG(1, "%s takes %u counter damage from %s\n",
                 status_description(att_status).c_str(), counter_dmg,
                 status_description(def_status).c_str());
-            remove_hp(fd, att_status, counter_dmg);
+            remove_hp<quest>(fd, att_status, counter_dmg);
             prepend_on_death(fd);
-            resolve_skill(fd);
+            resolve_skill<quest>(fd);
 
             // BGE: Counterflux
-            if (def_cardtype == CardType::assault && is_alive(def_status) && fd->bg_effects.count(PassiveBGE::counterflux))
+            if (def_cardtype == CardType::assault && is_alive(def_status) && fd->has_bg_effect(PassiveBGE::counterflux))
             {
-                unsigned flux_denominator = fd->bg_effects.at(PassiveBGE::counterflux) ? fd->bg_effects.at(PassiveBGE::counterflux) : 4;
+                unsigned flux_denominator = fd->bg_effects[PassiveBGE::counterflux] ? fd->bg_effects[PassiveBGE::counterflux] : 4;
                 unsigned flux_value = (def_status->skill(Skill::counter) - 1) / flux_denominator + 1;
                 _DEBUG_MSG(1, "Counterflux: %s heals itself and berserks for %u\n",
                     status_description(def_status).c_str(), flux_value);
@@ -1047,17 +1166,15 @@ struct PerformAttack
         {
             // perform_skill_berserk
             att_status->m_attack += berserk_value;
-#ifndef NQUEST
-            if (att_status->m_player == 0)
+            if (quest && att_status->m_player == 0)
             {
                 fd->inc_counter(QuestType::skill_use, Skill::berserk);
             }
-#endif
 
             // BGE: EnduringRage
-            if (fd->bg_effects.count(PassiveBGE::enduringrage))
+            if (fd->has_bg_effect(PassiveBGE::enduringrage))
             {
-                unsigned bge_denominator = fd->bg_effects.at(PassiveBGE::enduringrage) ? fd->bg_effects.at(PassiveBGE::enduringrage) : 2;
+                unsigned bge_denominator = fd->bg_effects[PassiveBGE::enduringrage] ? fd->bg_effects[PassiveBGE::enduringrage] : 2;
                 unsigned bge_value = (berserk_value - 1) / bge_denominator + 1;
                 _DEBUG_MSG(1, "EnduringRage: %s heals and protects itself for %u\n",
                     status_description(att_status).c_str(), bge_value);
@@ -1067,11 +1184,15 @@ struct PerformAttack
         }
 
         // Skill: Leech
-        do_leech<def_cardtype>();
+        do_leech<def_cardtype, quest>();
+
+        // Fast path: no passive BGE
+        if (__builtin_expect(!fd->bg_effects_mask, true))
+        { return att_dmg; }
 
         // BGE: Heroism
-        unsigned valor_value = att_status->skill(Skill::valor);
-        if (valor_value > 0 && ! att_status->m_sundered && fd->bg_effects.count(PassiveBGE::heroism)
+        unsigned valor_value = fd->has_bg_effect(PassiveBGE::heroism) ? att_status->skill(Skill::valor) : 0;
+        if (valor_value > 0 && ! att_status->m_sundered
             && def_cardtype == CardType::assault && def_status->m_hp <= 0)
         {
             _DEBUG_MSG(1, "Heroism: %s gain %u attack\n",
@@ -1080,10 +1201,10 @@ struct PerformAttack
         }
 
         // BGE: Devour
-        unsigned leech_value = att_status->skill(Skill::leech) + att_status->skill(Skill::refresh);
-        if (fd->bg_effects.count(PassiveBGE::devour) && def_cardtype == CardType::assault && leech_value)
+        unsigned leech_value = fd->has_bg_effect(PassiveBGE::devour) ? att_status->skill(Skill::leech) + att_status->skill(Skill::refresh) : 0;
+        if (def_cardtype == CardType::assault && leech_value)
         {
-            unsigned bge_denominator = fd->bg_effects.at(PassiveBGE::devour) ? fd->bg_effects.at(PassiveBGE::devour) : 4;
+            unsigned bge_denominator = fd->bg_effects[PassiveBGE::devour] ? fd->bg_effects[PassiveBGE::devour] : 4;
             unsigned bge_value = (leech_value - 1) / bge_denominator + 1;
             if (! att_status->m_sundered)
             {
@@ -1132,12 +1253,7 @@ struct PerformAttack
             unsigned coalition_base = att_status->skill(Skill::coalition);
             if (coalition_base > 0)
             {
-                uint8_t factions_bitmap = 0;
-                for (CardStatus * status : fd->tap->assaults.m_indirect)
-                {
-                    if (! is_alive(status)) { continue; }
-                    factions_bitmap |= (1 << (status->m_card->m_faction));
-                }
+                uint8_t factions_bitmap = fd->tap->alive_factions_bitmap;
                 assert(factions_bitmap);
                 unsigned uniq_factions = byte_bits_count(factions_bitmap);
                 unsigned coalition_value = coalition_base * uniq_factions;
@@ -1179,7 +1295,7 @@ struct PerformAttack
         std::string reduced_desc;
         unsigned reduced_dmg(0);
         unsigned armor_value = def_status->skill(Skill::armor);
-        if (def_status->m_card->m_type == CardType::assault && fd->bg_effects.count(PassiveBGE::fortification))
+        if (def_status->m_card->m_type == CardType::assault && fd->has_bg_effect(PassiveBGE::fortification))
         {
             for (auto && adj_status: fd->adjacent_assaults(def_status))
             {
@@ -1211,7 +1327,7 @@ struct PerformAttack
                 status_description(att_status).c_str(),
                 status_description(def_status).c_str(), pre_modifier_dmg, desc.c_str());
         }
-        if (legion_value > 0 && can_be_healed(att_status) && fd->bg_effects.count(PassiveBGE::brigade))
+        if (legion_value > 0 && can_be_healed(att_status) && fd->has_bg_effect(PassiveBGE::brigade))
         {
             _DEBUG_MSG(1, "Brigade: %s heals itself for %u\n",
                 status_description(att_status).c_str(), legion_value);
@@ -1219,100 +1335,94 @@ struct PerformAttack
         }
     }
 
-    template<enum CardType::CardType>
+    template<enum CardType::CardType def_cardtype, bool quest>
     void attack_damage()
     {
-        remove_hp(fd, def_status, att_dmg);
+        if (def_cardtype == CardType::commander)
+        {
+            remove_commander_hp(fd, *def_status, att_dmg, true);
+            return;
+        }
+        remove_hp<quest>(fd, def_status, att_dmg);
         prepend_on_death(fd);
-        resolve_skill(fd);
+        resolve_skill<quest>(fd);
     }
 
-    template<enum CardType::CardType>
-    void damage_dependant_pre_oa() {}
-
-    template<enum CardType::CardType>
-    void do_leech() {}
-};
-
-template<>
-void PerformAttack::attack_damage<CardType::commander>()
-{
-    remove_commander_hp(fd, *def_status, att_dmg, true);
-}
-
-template<>
-void PerformAttack::damage_dependant_pre_oa<CardType::assault>()
-{
-    unsigned poison_value = std::max(att_status->skill(Skill::poison), att_status->skill(Skill::venom));
-    if (poison_value > def_status->m_poisoned && skill_check<Skill::poison>(fd, att_status, def_status))
+    template<enum CardType::CardType def_cardtype, bool quest>
+    void damage_dependant_pre_oa()
     {
-        // perform_skill_poison
-#ifndef NQUEST
-        if (att_status->m_player == 0)
+        if (def_cardtype != CardType::assault) { return; }
+        unsigned poison_value = std::max(att_status->skill(Skill::poison), att_status->skill(Skill::venom));
+        if (poison_value > def_status->m_poisoned && skill_check<Skill::poison>(fd, att_status, def_status))
         {
-            fd->inc_counter(QuestType::skill_use, Skill::poison);
+            // perform_skill_poison
+            if (quest && att_status->m_player == 0)
+            {
+                fd->inc_counter(QuestType::skill_use, Skill::poison);
+            }
+            _DEBUG_MSG(1, "%s poisons %s by %u\n",
+                status_description(att_status).c_str(),
+                status_description(def_status).c_str(), poison_value);
+            def_status->m_poisoned = poison_value;
         }
-#endif
-        _DEBUG_MSG(1, "%s poisons %s by %u\n",
-            status_description(att_status).c_str(),
-            status_description(def_status).c_str(), poison_value);
-        def_status->m_poisoned = poison_value;
-    }
 
-    // Damage-Dependent skill: Inhibit
-    unsigned inhibit_value = att_status->skill(Skill::inhibit);
-    if (inhibit_value > def_status->m_inhibited && skill_check<Skill::inhibit>(fd, att_status, def_status))
-    {
-        _DEBUG_MSG(1, "%s inhibits %s by %u\n",
-            status_description(att_status).c_str(),
-            status_description(def_status).c_str(), inhibit_value);
-        def_status->m_inhibited = inhibit_value;
-    }
+        // Damage-Dependent skill: Inhibit
+        unsigned inhibit_value = att_status->skill(Skill::inhibit);
+        if (inhibit_value > def_status->m_inhibited && skill_check<Skill::inhibit>(fd, att_status, def_status))
+        {
+            _DEBUG_MSG(1, "%s inhibits %s by %u\n",
+                status_description(att_status).c_str(),
+                status_description(def_status).c_str(), inhibit_value);
+            def_status->m_inhibited = inhibit_value;
+        }
 
-    // Damage-Dependent skill: Sabotage
-    unsigned sabotage_value = att_status->skill(Skill::sabotage);
-    if (sabotage_value > def_status->m_sabotaged && skill_check<Skill::sabotage>(fd, att_status, def_status))
-    {
-        _DEBUG_MSG(1, "%s sabotages %s by %u\n",
-            status_description(att_status).c_str(),
-            status_description(def_status).c_str(), sabotage_value);
-        def_status->m_sabotaged = sabotage_value;
+        // Damage-Dependent skill: Sabotage
+        unsigned sabotage_value = att_status->skill(Skill::sabotage);
+        if (sabotage_value > def_status->m_sabotaged && skill_check<Skill::sabotage>(fd, att_status, def_status))
+        {
+            _DEBUG_MSG(1, "%s sabotages %s by %u\n",
+                status_description(att_status).c_str(),
+                status_description(def_status).c_str(), sabotage_value);
+            def_status->m_sabotaged = sabotage_value;
+        }
     }
-}
 
-template<>
-void PerformAttack::do_leech<CardType::assault>()
-{
-    unsigned leech_value = std::min(att_dmg, att_status->skill(Skill::leech));
-    if(leech_value > 0 && skill_check<Skill::leech>(fd, att_status, nullptr))
+    template<enum CardType::CardType def_cardtype, bool quest>
+    void do_leech()
     {
-#ifndef NQUEST
-        if (att_status->m_player == 0)
+        if (def_cardtype != CardType::assault) { return; }
+        unsigned leech_value = std::min(att_dmg, att_status->skill(Skill::leech));
+        if(leech_value > 0 && skill_check<Skill::leech>(fd, att_status, nullptr))
         {
-            fd->inc_counter(QuestType::skill_use, Skill::leech);
+            if (quest && att_status->m_player == 0)
+            {
+                fd->inc_counter(QuestType::skill_use, Skill::leech);
+            }
+            _DEBUG_MSG(1, "%s leeches %u health\n", status_description(att_status).c_str(), leech_value);
+            add_hp(fd, att_status, leech_value);
         }
-#endif
-        _DEBUG_MSG(1, "%s leeches %u health\n", status_description(att_status).c_str(), leech_value);
-        add_hp(fd, att_status, leech_value);
     }
-}
+};
 
 // General attack phase by the currently evaluated assault, taking into accounts exotic stuff such as flurry, etc.
+template<bool quest>
 unsigned attack_commander(Field* fd, CardStatus* att_status)
 {
     CardStatus* def_status{select_first_enemy_wall(fd)}; // defending wall
     if(def_status != nullptr)
     {
-        return PerformAttack{fd, att_status, def_status}.op<CardType::structure>();
+        return PerformAttack{fd, att_status, def_status}.op<CardType::structure, quest>();
     }
     else
     {
-        return PerformAttack{fd, att_status, &fd->tip->commander}.op<CardType::commander>();
+        return PerformAttack{fd, att_status, &fd->tip->commander}.op<CardType::commander, quest>();
     }
 }
 // Return true if actually attacks
+template<bool quest>
 bool attack_phase(Field* fd)
 {
+    TUO_PROFILE_PHASE(fd, attack);
     CardStatus* att_status(&fd->tap->assaults[fd->current_ci]); // attacking card
     Storage<CardStatus>& def_assaults(fd->tip->assaults);
 
@@ -1326,12 +1436,12 @@ bool attack_phase(Field* fd)
     if (alive_assault(def_assaults, fd->current_ci))
     {
         CardStatus * def_status = &fd->tip->assaults[fd->current_ci];
-        att_dmg = PerformAttack{fd, att_status, def_status}.op<CardType::assault>();
+        att_dmg = PerformAttack{fd, att_status, def_status}.op<CardType::assault, quest>();
         unsigned swipe_value = att_status->skill(Skill::swipe);
         unsigned drain_value = att_status->skill(Skill::drain);
         if (swipe_value || drain_value)
         {
-            bool critical_reach = fd->bg_effects.count(PassiveBGE::criticalreach);
+            bool critical_reach = fd->has_bg_effect(PassiveBGE::criticalreach);
             auto drain_total_dmg = att_dmg;
             for (auto && adj_status: fd->adjacent_assaults(def_status, critical_reach ? 2 : 1))
             {
@@ -1341,7 +1451,7 @@ bool attack_phase(Field* fd)
                 _DEBUG_MSG(1, "%s swipes %s for %u damage\n",
                     status_description(att_status).c_str(),
                     status_description(adj_status).c_str(), swipe_dmg);
-                remove_hp(fd, adj_status, swipe_dmg);
+                remove_hp<quest>(fd, adj_status, swipe_dmg);
                 drain_total_dmg += swipe_dmg;
             }
             if (drain_value && skill_check<Skill::drain>(fd, att_status, nullptr))
@@ -1351,18 +1461,18 @@ bool attack_phase(Field* fd)
                 add_hp(fd, att_status, drain_total_dmg);
             }
             prepend_on_death(fd);
-            resolve_skill(fd);
+            resolve_skill<quest>(fd);
         }
     }
     else
     {
         // might be blocked by walls
-        att_dmg = attack_commander(fd, att_status);
+        att_dmg = attack_commander<quest>(fd, att_status);
     }
 
-    if (att_dmg > 0 && !fd->assault_bloodlusted && fd->bg_effects.count(PassiveBGE::bloodlust))
+    if (att_dmg > 0 && !fd->assault_bloodlusted && fd->has_bg_effect(PassiveBGE::bloodlust))
     {
-        fd->bloodlust_value += fd->bg_effects.at(PassiveBGE::bloodlust);
+        fd->bloodlust_value += fd->bg_effects[PassiveBGE::bloodlust];
         fd->assault_bloodlusted = true;
     }
 
@@ -1476,9 +1586,9 @@ inline bool skill_predicate<Skill::overload>(Field* fd, CardStatus* src, CardSta
         return false;
     }
     bool has_inhibited_unit = false;
-    for (const auto & c: fd->players[dst->m_player]->assaults.m_indirect)
+    for (CardStatus & c : fd->players[dst->m_player]->assaults)
     {
-        if (is_alive(c) && c->m_inhibited)
+        if (is_alive(&c) && c.m_inhibited)
         {
             has_inhibited_unit = true;
             break;
@@ -1486,11 +1596,11 @@ inline bool skill_predicate<Skill::overload>(Field* fd, CardStatus* src, CardSta
     }
     for (const auto & ss: dst->m_card->m_skills)
     {
-        if (dst->m_skill_cd[ss.id] > 0)
+        if (dst->m_skill_cd[dst->skill_slot(ss.id)] > 0)
         {
             continue;
         }
-        Skill::Skill evolved_skill_id = static_cast<Skill::Skill>(ss.id + dst->m_evolved_skill_offset[ss.id]);
+        Skill::Skill evolved_skill_id = static_cast<Skill::Skill>(ss.id + dst->m_evolved_skill_offset[dst->skill_slot(ss.id)]);
         if (is_activation_hostile_skill(evolved_skill_id))
         {
             return true;
@@ -1537,6 +1647,15 @@ template<unsigned skill_id>
 inline void perform_skill(Field* fd, CardStatus* src, CardStatus* dst, const SkillSpec& s)
 { assert(false); }
 
+// Skills that deal damage, trigger Valor or perform another skill reach the quest
+// counting, and are specialized on it below.
+template<unsigned skill_id, bool quest>
+struct PerformSkill
+{
+    static void op(Field* fd, CardStatus* src, CardStatus* dst, const SkillSpec& s)
+    { perform_skill<skill_id>(fd, src, dst, s); }
+};
+
 template<>
 inline void perform_skill<Skill::enfeeble>(Field* fd, CardStatus* src, CardStatus* dst, const SkillSpec& s)
 {
@@ -1546,25 +1665,29 @@ inline void perform_skill<Skill::enfeeble>(Field* fd, CardStatus* src, CardStatu
 template<>
 inline void perform_skill<Skill::enhance>(Field* fd, CardStatus* src, CardStatus* dst, const SkillSpec& s)
 {
-    dst->m_enhanced_value[s.s + dst->m_primary_skill_offset[s.s]] += s.x;
+    dst->m_enhanced_value[dst->skill_slot(dst->primary_skill(s.s))] += s.x;
+    dst->m_skills_modified = true;
 }
 
 template<>
 inline void perform_skill<Skill::evolve>(Field* fd, CardStatus* src, CardStatus* dst, const SkillSpec& s)
 {
-    auto primary_s1 = dst->m_primary_skill_offset[s.s] + s.s;
-    auto primary_s2 = dst->m_primary_skill_offset[s.s2] + s.s2;
-    dst->m_primary_skill_offset[s.s] = primary_s2 - s.s;
-    dst->m_primary_skill_offset[s.s2] = primary_s1 - s.s2;
-    dst->m_evolved_skill_offset[primary_s1] = s.s2 - primary_s1;
-    dst->m_evolved_skill_offset[primary_s2] = s.s - primary_s2;
+    unsigned slot_s2 = dst->track_skill(s.s2);
+    unsigned slot_s1 = dst->skill_slot(s.s);
+    auto primary_s1 = dst->primary_skill(s.s);
+    auto primary_s2 = dst->primary_skill(s.s2);
+    dst->m_primary_skill_offset[slot_s1] = primary_s2 - s.s;
+    dst->m_primary_skill_offset[slot_s2] = primary_s1 - s.s2;
+    dst->m_evolved_skill_offset[dst->skill_slot(primary_s1)] = s.s2 - primary_s1;
+    dst->m_evolved_skill_offset[dst->skill_slot(primary_s2)] = s.s - primary_s2;
+    dst->m_skills_modified = true;
 }
 
 template<>
 inline void perform_skill<Skill::heal>(Field* fd, CardStatus* src, CardStatus* dst, const SkillSpec& s)
 {
     add_hp(fd, dst, s.x);
-    if (src->m_card->m_type == CardType::assault && fd->bg_effects.count(PassiveBGE::zealotspreservation))
+    if (src->m_card->m_type == CardType::assault && fd->has_bg_effect(PassiveBGE::zealotspreservation))
     {
         unsigned bge_value = (s.x + 1) / 2;
         _DEBUG_MSG(1, "Zealot's Preservation: %s Protect %u on %s\n",
@@ -1586,20 +1709,6 @@ inline void perform_skill<Skill::mend>(Field* fd, CardStatus* src, CardStatus* d
     add_hp(fd, dst, s.x);
 }
 
-template<>
-inline void perform_skill<Skill::mortar>(Field* fd, CardStatus* src, CardStatus* dst, const SkillSpec& s)
-{
-    if (dst->m_card->m_type == CardType::structure)
-    {
-        remove_hp(fd, dst, s.x);
-    }
-    else
-    {
-        unsigned strike_dmg = safe_minus((s.x + 1) / 2 + dst->m_enfeebled, src->m_overloaded ? 0 : dst->protected_value());
-        remove_hp(fd, dst, strike_dmg);
-    }
-}
-
 template<>
 inline void perform_skill<Skill::overload>(Field* fd, CardStatus* src, CardStatus* dst, const SkillSpec& s)
 {
@@ -1622,7 +1731,7 @@ template<>
 inline void perform_skill<Skill::enrage>(Field* fd, CardStatus* src, CardStatus* dst, const SkillSpec& s)
 {
     dst->m_enraged += s.x;
-    if (fd->bg_effects.count(PassiveBGE::furiosity) && can_be_healed(dst))
+    if (fd->has_bg_effect(PassiveBGE::furiosity) && can_be_healed(dst))
     {
         unsigned bge_value = s.x;
         _DEBUG_MSG(1, "Furiosity: %s Heals %s for %u\n",
@@ -1632,29 +1741,6 @@ inline void perform_skill<Skill::enrage>(Field* fd, CardStatus* src, CardStatus*
     }
 }
 
-template<>
-inline void perform_skill<Skill::rush>(Field* fd, CardStatus* src, CardStatus* dst, const SkillSpec& s)
-{
-    dst->m_delay -= std::min(std::max(s.x, 1u), dst->m_delay);
-    if (dst->m_delay == 0)
-    {
-        check_and_perform_valor(fd, dst);
-    }
-}
-
-template<>
-inline void perform_skill<Skill::siege>(Field* fd, CardStatus* src, CardStatus* dst, const SkillSpec& s)
-{
-    remove_hp(fd, dst, s.x);
-}
-
-template<>
-inline void perform_skill<Skill::strike>(Field* fd, CardStatus* src, CardStatus* dst, const SkillSpec& s)
-{
-    unsigned strike_dmg = safe_minus(s.x + dst->m_enfeebled, src->m_overloaded ? 0 : dst->protected_value());
-    remove_hp(fd, dst, strike_dmg);
-}
-
 template<>
 inline void perform_skill<Skill::weaken>(Field* fd, CardStatus* src, CardStatus* dst, const SkillSpec& s)
 {
@@ -1675,51 +1761,119 @@ inline void perform_skill<Skill::sunder>(Field* fd, CardStatus* src, CardStatus*
     perform_skill<Skill::weaken>(fd, src, dst, s);
 }
 
-template<>
-inline void perform_skill<Skill::mimic>(Field* fd, CardStatus* src, CardStatus* dst, const SkillSpec& s)
+template<bool quest>
+struct PerformSkill<Skill::mortar, quest>
 {
-    // collect all mimickable enemy skills
-    std::vector<const SkillSpec *> mimickable_skills;
-    _DEBUG_MSG(2, " * Mimickable skills of %s\n", status_description(dst).c_str());
-    for (const auto & ss: dst->m_card->m_skills)
+    static void op(Field* fd, CardStatus* src, CardStatus* dst, const SkillSpec& s)
     {
-        // get skill
-        Skill::Skill skill_id = static_cast<Skill::Skill>(ss.id);
-
-        // skip non-activation skills and Mimic (Mimic can't be mimicked)
-        if (!is_activation_skill(skill_id) || (skill_id == Skill::mimic))
-        { continue; }
+        if (dst->m_card->m_type == CardType::structure)
+        {
+            remove_hp<quest>(fd, dst, s.x);
+        }
+        else
+        {
+            unsigned strike_dmg = safe_minus((s.x + 1) / 2 + dst->m_enfeebled, src->m_overloaded ? 0 : dst->protected_value());
+            remove_hp<quest>(fd, dst, strike_dmg);
+        }
+    }
+};
 
-        // skip mend for non-assault mimickers
-        if ((skill_id == Skill::mend) && (src->m_card->m_type != CardType::assault))
-        { continue; }
+template<bool quest>
+struct PerformSkill<Skill::rush, quest>
+{
+    static void op(Field* fd, CardStatus* src, CardStatus* dst, const SkillSpec& s)
+    {
+        dst->m_delay -= std::min(std::max(s.x, 1u), dst->m_delay);
+        if (dst->m_delay == 0)
+        {
+            check_and_perform_valor<quest>(fd, dst);
+        }
+    }
+};
 
-        mimickable_skills.emplace_back(&ss);
-        _DEBUG_MSG(2, "  + %s\n", skill_description(ss).c_str());
+template<bool quest>
+struct PerformSkill<Skill::siege, quest>
+{
+    static void op(Field* fd, CardStatus* src, CardStatus* dst, const SkillSpec& s)
+    {
+        remove_hp<quest>(fd, dst, s.x);
     }
+};
 
-    // select skill
-    unsigned mim_idx = 0;
-    switch (mimickable_skills.size())
+template<bool quest>
+struct PerformSkill<Skill::strike, quest>
+{
+    static void op(Field* fd, CardStatus* src, CardStatus* dst, const SkillSpec& s)
     {
-    case 0: assert(false); break;
-    case 1: break;
-    default: mim_idx = (fd->re() % mimickable_skills.size()); break;
+        unsigned strike_dmg = safe_minus(s.x + dst->m_enfeebled, src->m_overloaded ? 0 : dst->protected_value());
+        remove_hp<quest>(fd, dst, strike_dmg);
     }
+};
 
-    // prepare & perform selected skill
-    const SkillSpec & mim_ss = *mimickable_skills[mim_idx];
-    Skill::Skill mim_skill_id = static_cast<Skill::Skill>(mim_ss.id);
-    auto skill_value = s.x + src->enhanced(mim_skill_id);
-    SkillSpec mimicked_ss{mim_skill_id, skill_value, allfactions, mim_ss.n, 0, mim_ss.s, mim_ss.s2, mim_ss.all};
-    _DEBUG_MSG(1, " * Mimicked skill: %s\n", skill_description(mimicked_ss).c_str());
-    skill_table[mim_skill_id](fd, src, mimicked_ss);
-}
+template<bool quest>
+struct PerformSkill<Skill::mimic, quest>
+{
+    static void op(Field* fd, CardStatus* src, CardStatus* dst, const SkillSpec& s)
+    {
+        // count all mimickable enemy skills
+        auto is_mimickable = [src](const SkillSpec & ss)
+        {
+            // get skill
+            Skill::Skill skill_id = static_cast<Skill::Skill>(ss.id);
+
+            // skip non-activation skills and Mimic (Mimic can't be mimicked)
+            if (!is_activation_skill(skill_id) || (skill_id == Skill::mimic))
+            { return false; }
+
+            // skip mend for non-assault mimickers
+            if ((skill_id == Skill::mend) && (src->m_card->m_type != CardType::assault))
+            { return false; }
+
+            return true;
+        };
+        unsigned num_mimickable_skills(0);
+        _DEBUG_MSG(2, " * Mimickable skills of %s\n", status_description(dst).c_str());
+        for (const auto & ss: dst->m_card->m_skills)
+        {
+            if (is_mimickable(ss))
+            {
+                ++ num_mimickable_skills;
+                _DEBUG_MSG(2, "  + %s\n", skill_description(ss).c_str());
+            }
+        }
+
+        // select skill
+        unsigned mim_idx = 0;
+        switch (num_mimickable_skills)
+        {
+        case 0: assert(false); break;
+        case 1: break;
+        default: mim_idx = (fd->re() % num_mimickable_skills); break;
+        }
+        const SkillSpec * mim_ss_ptr = nullptr;
+        for (const auto & ss: dst->m_card->m_skills)
+        {
+            if (is_mimickable(ss) && mim_idx-- == 0)
+            {
+                mim_ss_ptr = &ss;
+                break;
+            }
+        }
+
+        // prepare & perform selected skill
+        const SkillSpec & mim_ss = *mim_ss_ptr;
+        Skill::Skill mim_skill_id = static_cast<Skill::Skill>(mim_ss.id);
+        auto skill_value = s.x + src->enhanced(mim_skill_id);
+        SkillSpec mimicked_ss{mim_skill_id, skill_value, allfactions, mim_ss.n, 0, mim_ss.s, mim_ss.s2, mim_ss.all};
+        _DEBUG_MSG(1, " * Mimicked skill: %s\n", skill_description(mimicked_ss).c_str());
+        (quest ? quest_skill_table : skill_table)[mim_skill_id](fd, src, mimicked_ss);
+    }
+};
 
 template<unsigned skill_id>
-inline unsigned select_fast(Field* fd, CardStatus* src, const std::vector<CardStatus*>& cards, const SkillSpec& s)
+inline unsigned select_fast(Field* fd, CardStatus* src, Storage<CardStatus>& cards, const SkillSpec& s)
 {
-    if (s.y == allfactions || fd->bg_effects.count(PassiveBGE::metamorphosis))
+    if (s.y == allfactions || fd->has_bg_effect(PassiveBGE::metamorphosis))
     {
         return(fd->make_selection_array(cards.begin(), cards.end(), [fd, src, s](CardStatus* c){return(skill_predicate<skill_id>(fd, src, c, s));}));
     }
@@ -1730,10 +1884,10 @@ inline unsigned select_fast(Field* fd, CardStatus* src, const std::vector<CardSt
 }
 
 template<>
-inline unsigned select_fast<Skill::mend>(Field* fd, CardStatus* src, const std::vector<CardStatus*>& cards, const SkillSpec& s)
+inline unsigned select_fast<Skill::mend>(Field* fd, CardStatus* src, Storage<CardStatus>& cards, const SkillSpec& s)
 {
     fd->selection_array.clear();
-    bool critical_reach = fd->bg_effects.count(PassiveBGE::criticalreach);
+    bool critical_reach = fd->has_bg_effect(PassiveBGE::criticalreach);
     for (auto && adj_status: fd->adjacent_assaults(src, critical_reach ? 2 : 1))
     {
         if (skill_predicate<Skill::mend>(fd, src, adj_status, s))
@@ -1744,97 +1898,91 @@ inline unsigned select_fast<Skill::mend>(Field* fd, CardStatus* src, const std::
     return fd->selection_array.size();
 }
 
-inline std::vector<CardStatus*>& skill_targets_hostile_assault(Field* fd, CardStatus* src)
+inline Storage<CardStatus>& skill_targets_hostile_assault(Field* fd, CardStatus* src)
 {
-    return(fd->players[opponent(src->m_player)]->assaults.m_indirect);
+    return(fd->players[opponent(src->m_player)]->assaults);
 }
 
-inline std::vector<CardStatus*>& skill_targets_allied_assault(Field* fd, CardStatus* src)
+inline Storage<CardStatus>& skill_targets_allied_assault(Field* fd, CardStatus* src)
 {
-    return(fd->players[src->m_player]->assaults.m_indirect);
+    return(fd->players[src->m_player]->assaults);
 }
 
-inline std::vector<CardStatus*>& skill_targets_hostile_structure(Field* fd, CardStatus* src)
+inline Storage<CardStatus>& skill_targets_hostile_structure(Field* fd, CardStatus* src)
 {
-    return(fd->players[opponent(src->m_player)]->structures.m_indirect);
+    return(fd->players[opponent(src->m_player)]->structures);
 }
 
-inline std::vector<CardStatus*>& skill_targets_allied_structure(Field* fd, CardStatus* src)
+inline Storage<CardStatus>& skill_targets_allied_structure(Field* fd, CardStatus* src)
 {
-    return(fd->players[src->m_player]->structures.m_indirect);
+    return(fd->players[src->m_player]->structures);
 }
 
 template<unsigned skill>
-std::vector<CardStatus*>& skill_targets(Field* fd, CardStatus* src)
+Storage<CardStatus>& skill_targets(Field* fd, CardStatus* src)
 {
     std::cerr << "skill_targets: Error: no specialization for " << skill_names[skill] << "\n";
     throw;
 }
 
-template<> std::vector<CardStatus*>& skill_targets<Skill::enfeeble>(Field* fd, CardStatus* src)
+template<> Storage<CardStatus>& skill_targets<Skill::enfeeble>(Field* fd, CardStatus* src)
 { return(skill_targets_hostile_assault(fd, src)); }
 
-template<> std::vector<CardStatus*>& skill_targets<Skill::enhance>(Field* fd, CardStatus* src)
+template<> Storage<CardStatus>& skill_targets<Skill::enhance>(Field* fd, CardStatus* src)
 { return(skill_targets_allied_assault(fd, src)); }
 
-template<> std::vector<CardStatus*>& skill_targets<Skill::evolve>(Field* fd, CardStatus* src)
+template<> Storage<CardStatus>& skill_targets<Skill::evolve>(Field* fd, CardStatus* src)
 { return(skill_targets_allied_assault(fd, src)); }
 
-template<> std::vector<CardStatus*>& skill_targets<Skill::heal>(Field* fd, CardStatus* src)
+template<> Storage<CardStatus>& skill_targets<Skill::heal>(Field* fd, CardStatus* src)
 { return(skill_targets_allied_assault(fd, src)); }
 
-template<> std::vector<CardStatus*>& skill_targets<Skill::jam>(Field* fd, CardStatus* src)
+template<> Storage<CardStatus>& skill_targets<Skill::jam>(Field* fd, CardStatus* src)
 { return(skill_targets_hostile_assault(fd, src)); }
 
-template<> std::vector<CardStatus*>& skill_targets<Skill::mend>(Field* fd, CardStatus* src)
+template<> Storage<CardStatus>& skill_targets<Skill::mend>(Field* fd, CardStatus* src)
 { return(skill_targets_allied_assault(fd, src)); }
 
-template<> std::vector<CardStatus*>& skill_targets<Skill::overload>(Field* fd, CardStatus* src)
+template<> Storage<CardStatus>& skill_targets<Skill::overload>(Field* fd, CardStatus* src)
 { return(skill_targets_allied_assault(fd, src)); }
 
-template<> std::vector<CardStatus*>& skill_targets<Skill::protect>(Field* fd, CardStatus* src)
+template<> Storage<CardStatus>& skill_targets<Skill::protect>(Field* fd, CardStatus* src)
 { return(skill_targets_allied_assault(fd, src)); }
 
-template<> std::vector<CardStatus*>& skill_targets<Skill::rally>(Field* fd, CardStatus* src)
+template<> Storage<CardStatus>& skill_targets<Skill::rally>(Field* fd, CardStatus* src)
 { return(skill_targets_allied_assault(fd, src)); }
 
-template<> std::vector<CardStatus*>& skill_targets<Skill::enrage>(Field* fd, CardStatus* src)
+template<> Storage<CardStatus>& skill_targets<Skill::enrage>(Field* fd, CardStatus* src)
 { return(skill_targets_allied_assault(fd, src)); }
 
-template<> std::vector<CardStatus*>& skill_targets<Skill::rush>(Field* fd, CardStatus* src)
+template<> Storage<CardStatus>& skill_targets<Skill::rush>(Field* fd, CardStatus* src)
 { return(skill_targets_allied_assault(fd, src)); }
 
-template<> std::vector<CardStatus*>& skill_targets<Skill::siege>(Field* fd, CardStatus* src)
+template<> Storage<CardStatus>& skill_targets<Skill::siege>(Field* fd, CardStatus* src)
 { return(skill_targets_hostile_structure(fd, src)); }
 
-template<> std::vector<CardStatus*>& skill_targets<Skill::strike>(Field* fd, CardStatus* src)
+template<> Storage<CardStatus>& skill_targets<Skill::strike>(Field* fd, CardStatus* src)
 { return(skill_targets_hostile_assault(fd, src)); }
 
-template<> std::vector<CardStatus*>& skill_targets<Skill::sunder>(Field* fd, CardStatus* src)
+template<> Storage<CardStatus>& skill_targets<Skill::sunder>(Field* fd, CardStatus* src)
 { return(skill_targets_hostile_assault(fd, src)); }
 
-template<> std::vector<CardStatus*>& skill_targets<Skill::weaken>(Field* fd, CardStatus* src)
+template<> Storage<CardStatus>& skill_targets<Skill::weaken>(Field* fd, CardStatus* src)
 { return(skill_targets_hostile_assault(fd, src)); }
 
-template<> std::vector<CardStatus*>& skill_targets<Skill::mimic>(Field* fd, CardStatus* src)
+template<> Storage<CardStatus>& skill_targets<Skill::mimic>(Field* fd, CardStatus* src)
 { return(skill_targets_hostile_assault(fd, src)); }
 
-template<Skill::Skill skill_id>
-bool check_and_perform_skill(Field* fd, CardStatus* src, CardStatus* dst, const SkillSpec& s, bool is_evadable
-#ifndef NQUEST
-    , bool & has_counted_quest
-#endif
-)
+template<Skill::Skill skill_id, bool quest>
+bool check_and_perform_skill(Field* fd, CardStatus* src, CardStatus* dst, const SkillSpec& s, bool is_evadable, bool & has_counted_quest)
 {
     if(skill_check<skill_id>(fd, src, dst))
     {
-#ifndef NQUEST
-        if (src->m_player == 0 && ! has_counted_quest)
+        if (quest && src->m_player == 0 && ! has_counted_quest)
         {
             fd->inc_counter(QuestType::skill_use, skill_id, dst->m_card->m_id);
             has_counted_quest = true;
         }
-#endif
         if (is_evadable &&
                 dst->m_evaded < dst->skill(Skill::evade) &&
                 skill_check<Skill::evade>(fd, dst, src))
@@ -1848,10 +1996,12 @@ bool check_and_perform_skill(Field* fd, CardStatus* src, CardStatus* dst, const
         _DEBUG_MSG(1, "%s %s on %s\n",
             status_description(src).c_str(), skill_short_description(s).c_str(),
             status_description(dst).c_str());
-        perform_skill<skill_id>(fd, src, dst, s);
+        PerformSkill<skill_id, quest>::op(fd, src, dst, s);
         if (s.c > 0)
         {
-            src->m_skill_cd[skill_id] = s.c;
+            // cooldown of a skill the card does not have (evolved into) is never read
+            unsigned slot = src->skill_slot(static_cast<Skill::Skill>(skill_id));
+            if (slot != 0) { src->m_skill_cd[slot] = s.c; }
         }
         return(true);
     }
@@ -1861,6 +2011,7 @@ bool check_and_perform_skill(Field* fd, CardStatus* src, CardStatus* dst, const
     return(false);
 }
 
+template<bool quest>
 bool check_and_perform_valor(Field* fd, CardStatus* src)
 {
     unsigned valor_value = src->skill(Skill::valor);
@@ -1880,12 +2031,10 @@ bool check_and_perform_valor(Field* fd, CardStatus* src)
             _DEBUG_MSG(1, "%s loses Valor (weak blocker %s)\n", status_description(src).c_str(), status_description(dst).c_str());
             return false;
         }
-#ifndef NQUEST
-        if (src->m_player == 0)
+        if (quest && src->m_player == 0)
         {
             fd->inc_counter(QuestType::skill_use, Skill::valor);
         }
-#endif
         _DEBUG_MSG(1, "%s activates Valor %u\n", status_description(src).c_str(), valor_value);
         src->m_attack += valor_value;
         return true;
@@ -1946,14 +2095,12 @@ size_t select_targets(Field* fd, CardStatus* src, const SkillSpec& s)
     return n_selected;
 }
 
-template<Skill::Skill skill_id>
+template<Skill::Skill skill_id, bool quest>
 void perform_targetted_allied_fast(Field* fd, CardStatus* src, const SkillSpec& s)
 {
     select_targets<skill_id>(fd, src, s);
     unsigned num_inhibited = 0;
-#ifndef NQUEST
     bool has_counted_quest = false;
-#endif
     bool src_overloaded = src->m_overloaded;
     for (CardStatus * dst: fd->selection_array)
     {
@@ -1966,13 +2113,9 @@ void perform_targetted_allied_fast(Field* fd, CardStatus* src, const SkillSpec&
             ++ num_inhibited;
             continue;
         }
-        check_and_perform_skill<skill_id>(fd, src, dst, s, false
-#ifndef NQUEST
-            , has_counted_quest
-#endif
-        );
+        check_and_perform_skill<skill_id, quest>(fd, src, dst, s, false, has_counted_quest);
     }
-    if (num_inhibited > 0 && fd->bg_effects.count(PassiveBGE::divert))
+    if (num_inhibited > 0 && fd->has_bg_effect(PassiveBGE::divert))
     {
         SkillSpec diverted_ss = s;
         diverted_ss.y = allfactions;
@@ -1994,17 +2137,18 @@ void perform_targetted_allied_fast(Field* fd, CardStatus* src, const SkillSpec&
                 _DEBUG_MSG(1, "%s %s (Diverted) on %s\n",
                     status_description(src).c_str(), skill_short_description(diverted_ss).c_str(),
                     status_description(dst).c_str());
-                perform_skill<skill_id>(fd, src, dst, diverted_ss);
+                PerformSkill<skill_id, quest>::op(fd, src, dst, diverted_ss);
             }
         }
     }
 }
 
+template<bool quest>
 void perform_targetted_allied_fast_rush(Field* fd, CardStatus* src, const SkillSpec& s)
 {
     if (src->m_card->m_type == CardType::commander)
     {  // BGE skills are casted as by commander
-        perform_targetted_allied_fast<Skill::rush>(fd, src, s);
+        perform_targetted_allied_fast<Skill::rush, quest>(fd, src, s);
         return;
     }
     if (src->m_rush_attempted)
@@ -2013,23 +2157,27 @@ void perform_targetted_allied_fast_rush(Field* fd, CardStatus* src, const SkillS
         return;
     }
     _DEBUG_MSG(1, "%s attempts to activate Rush.\n", status_description(src).c_str());
-    perform_targetted_allied_fast<Skill::rush>(fd, src, s);
+    perform_targetted_allied_fast<Skill::rush, quest>(fd, src, s);
     src->m_rush_attempted = true;
 }
 
-template<Skill::Skill skill_id>
+template<Skill::Skill skill_id, bool quest>
 void perform_targetted_hostile_fast(Field* fd, CardStatus* src, const SkillSpec& s)
 {
     select_targets<skill_id>(fd, src, s);
-    std::vector<CardStatus *> paybackers;
-#ifndef NQUEST
+    // Mimic performs the mimicked skill, which selects its own targets: keep a copy of the selection.
+    decltype(fd->selection_array) mimic_targets;
+    if (skill_id == Skill::mimic)
+    {
+        mimic_targets = fd->selection_array;
+    }
+    FixedVector<CardStatus *, max_board_units> paybackers;
     bool has_counted_quest = false;
-#endif
-    const bool has_turningtides = (fd->bg_effects.count(PassiveBGE::turningtides) && (skill_id == Skill::weaken || skill_id == Skill::sunder));
+    const bool has_turningtides = (fd->has_bg_effect(PassiveBGE::turningtides) && (skill_id == Skill::weaken || skill_id == Skill::sunder));
     unsigned turningtides_value(0), old_attack(0);
 
     // apply skill to each target(dst)
-    for (CardStatus * dst: fd->selection_array)
+    for (CardStatus * dst: skill_id == Skill::mimic ? mimic_targets : fd->selection_array)
     {
         // TurningTides
         if (has_turningtides)
@@ -2038,11 +2186,7 @@ void perform_targetted_hostile_fast(Field* fd, CardStatus* src, const SkillSpec&
         }
 
         // check & apply skill to target(dst)
-        if (check_and_perform_skill<skill_id>(fd, src, dst, s, ! src->m_overloaded
-#ifndef NQUEST
-            , has_counted_quest
-#endif
-        ))
+        if (check_and_perform_skill<skill_id, quest>(fd, src, dst, s, ! src->m_overloaded, has_counted_quest))
         {
             // TurningTides: get max attack decreasing
             if (has_turningtides)
@@ -2064,7 +2208,7 @@ void perform_targetted_hostile_fast(Field* fd, CardStatus* src, const SkillSpec&
     {
         SkillSpec ss_rally{Skill::rally, turningtides_value, allfactions, 0, 0, Skill::no_skill, Skill::no_skill, s.all,};
         _DEBUG_MSG(1, "TurningTides %u!\n", turningtides_value);
-        perform_targetted_allied_fast<Skill::rally>(fd, &fd->players[src->m_player]->commander, ss_rally);
+        perform_targetted_allied_fast<Skill::rally, quest>(fd, &fd->players[src->m_player]->commander, ss_rally);
     }
 
     prepend_on_death(fd);  // skills
@@ -2139,7 +2283,7 @@ void perform_targetted_hostile_fast(Field* fd, CardStatus* src, const SkillSpec&
                 _DEBUG_MSG(1, "%s Revenge (to %s) %s on %s\n",
                     status_description(pb_status).c_str(), target_desc,
                     skill_short_description(s).c_str(), status_description(target_status).c_str());
-                perform_skill<skill_id>(fd, pb_status, target_status, s);
+                PerformSkill<skill_id, quest>::op(fd, pb_status, target_status, s);
                 ++ revenged_count;
 
                 // revenged TurningTides: get max attack decreasing
@@ -2158,7 +2302,7 @@ void perform_targetted_hostile_fast(Field* fd, CardStatus* src, const SkillSpec&
                 {
                     SkillSpec ss_rally{Skill::rally, turningtides_value, allfactions, 0, 0, Skill::no_skill, Skill::no_skill, false,};
                     _DEBUG_MSG(1, "Paybacked TurningTides %u!\n", turningtides_value);
-                    perform_targetted_allied_fast<Skill::rally>(fd, &fd->players[pb_status->m_player]->commander, ss_rally);
+                    perform_targetted_allied_fast<Skill::rally, quest>(fd, &fd->players[pb_status->m_player]->commander, ss_rally);
                 }
             }
         }
@@ -2189,7 +2333,7 @@ void perform_targetted_hostile_fast(Field* fd, CardStatus* src, const SkillSpec&
             // apply paybacked skill
             _DEBUG_MSG(1, "%s Payback %s on %s\n",
                 status_description(pb_status).c_str(), skill_short_description(s).c_str(), status_description(src).c_str());
-            perform_skill<skill_id>(fd, pb_status, src, s);
+            PerformSkill<skill_id, quest>::op(fd, pb_status, src, s);
             ++ pb_status->m_paybacked;
 
             // handle paybacked TurningTides
@@ -2200,7 +2344,7 @@ void perform_targetted_hostile_fast(Field* fd, CardStatus* src, const SkillSpec&
                 {
                     SkillSpec ss_rally{Skill::rally, turningtides_value, allfactions, 0, 0, Skill::no_skill, Skill::no_skill, false,};
                     _DEBUG_MSG(1, "Paybacked TurningTides %u!\n", turningtides_value);
-                    perform_targetted_allied_fast<Skill::rally>(fd, &fd->players[pb_status->m_player]->commander, ss_rally);
+                    perform_targetted_allied_fast<Skill::rally, quest>(fd, &fd->players[pb_status->m_player]->commander, ss_rally);
                 }
             }
         }
@@ -2222,11 +2366,19 @@ inline unsigned evaluate_brawl_score(Field* fd, unsigned player)
 }
 
 //------------------------------------------------------------------------------
-Results<uint64_t> play(Field* fd)
+// Passive BGE check of play_turns(): compiled out when the Field has no passive BGE.
+template<bool passive_bges>
+inline bool play_has_bg_effect(Field* fd, PassiveBGE::PassiveBGE bge)
+{
+    return(passive_bges && fd->has_bg_effect(bge));
+}
+//------------------------------------------------------------------------------
+template<gamemode_t gamemode, bool passive_bges, bool quest>
+void play_turns(Field* fd)
 {
     fd->players[0]->commander.m_player = 0;
     fd->players[1]->commander.m_player = 1;
-    fd->tapi = fd->gamemode == surge ? 1 : 0;
+    fd->tapi = gamemode == surge ? 1 : 0;
     fd->tipi = opponent(fd->tapi);
     fd->tap = fd->players[fd->tapi];
     fd->tip = fd->players[fd->tipi];
@@ -2237,11 +2389,11 @@ Results<uint64_t> play(Field* fd)
     {
         for (const Card* played_card: fd->tap->deck->dominion_cards)
         {
-            PlayCard(played_card, fd).op<CardType::structure>();
+            PlayCard(played_card, fd).op<CardType::structure, quest>();
         }
         for (const Card* played_card: fd->tap->deck->shuffled_forts)
         {
-            PlayCard(played_card, fd).op<CardType::structure>();
+            PlayCard(played_card, fd).op<CardType::structure, quest>();
         }
         std::swap(fd->tapi, fd->tipi);
         std::swap(fd->tap, fd->tip);
@@ -2253,24 +2405,25 @@ Results<uint64_t> play(Field* fd)
         // Initialize stuff, remove dead cards
         _DEBUG_MSG(1, "------------------------------------------------------------------------\n"
                 "TURN %u begins for %s\n", fd->turn, status_description(&fd->tap->commander).c_str());
-        turn_start_phase(fd);
+        turn_start_phase<quest>(fd);
 
         // Play a card
         const Card* played_card(fd->tap->deck->next());
         if(played_card)
         {
+            TUO_PROFILE_PHASE(fd, play_card);
             // Evaluate skill Allegiance
-            for (CardStatus * status : fd->tap->assaults.m_indirect)
+            for (CardStatus & status : fd->tap->assaults)
             {
-                unsigned allegiance_value = status->skill(Skill::allegiance);
-                assert(status->m_card);
-                if (allegiance_value > 0 && is_alive(status) && status->m_card->m_faction == played_card->m_faction)
+                unsigned allegiance_value = status.skill(Skill::allegiance);
+                assert(status.m_card);
+                if (allegiance_value > 0 && is_alive(&status) && status.m_card->m_faction == played_card->m_faction)
                 {
-                    _DEBUG_MSG(1, "%s activates Allegiance %u\n", status_description(status).c_str(), allegiance_value);
-                    if (! status->m_sundered)
-                    { status->m_attack += allegiance_value; }
-                    status->m_max_hp += allegiance_value;
-                    status->m_hp += allegiance_value;
+                    _DEBUG_MSG(1, "%s activates Allegiance %u\n", status_description(&status).c_str(), allegiance_value);
+                    if (! status.m_sundered)
+                    { status.m_attack += allegiance_value; }
+                    status.m_max_hp += allegiance_value;
+                    status.m_hp += allegiance_value;
                 }
             }
 
@@ -2279,10 +2432,10 @@ Results<uint64_t> play(Field* fd)
             switch(played_card->m_type)
             {
             case CardType::assault:
-                played_status = PlayCard(played_card, fd).op<CardType::assault>();
+                played_status = PlayCard(played_card, fd).op<CardType::assault, quest>();
                 break;
             case CardType::structure:
-                played_status = PlayCard(played_card, fd).op<CardType::structure>();
+                played_status = PlayCard(played_card, fd).op<CardType::structure, quest>();
                 break;
             case CardType::commander:
             case CardType::num_cardtypes:
@@ -2300,7 +2453,7 @@ Results<uint64_t> play(Field* fd)
 
                 // do played card have stasis? mark this faction for stasis check
                 if (played_status->skill(Skill::stasis)
-                    || (fd->bg_effects.count(PassiveBGE::temporalbacklash) && played_status->skill(Skill::counter)))
+                    || (play_has_bg_effect<passive_bges>(fd, PassiveBGE::temporalbacklash) && played_status->skill(Skill::counter)))
                 {
                     fd->tap->stasis_faction_bitmap |= played_faction_mask;
                 }
@@ -2321,40 +2474,40 @@ Results<uint64_t> play(Field* fd)
                         status_description(&fd->tap->commander).c_str(), stacked_stasis);
                 }
 #endif
-                for (CardStatus * status : fd->tap->structures.m_indirect)
+                for (CardStatus & status : fd->tap->structures)
                 {
-                    if (status->m_faction == played_status->m_faction)
+                    if (status.m_faction == played_status->m_faction)
                     {
-                        stacked_stasis += status->skill(Skill::stasis);
+                        stacked_stasis += status.skill(Skill::stasis);
 #ifndef NDEBUG
-                        if (status->skill(Skill::stasis) > 0)
+                        if (status.skill(Skill::stasis) > 0)
                         {
                             _DEBUG_MSG(2, "+ Stasis [%s]: stacks +%u stasis protection from %s (total stacked: %u)\n",
-                                faction_names[played_status->m_faction].c_str(), status->skill(Skill::stasis),
+                                faction_names[played_status->m_faction].c_str(), status.skill(Skill::stasis),
                                 status_description(played_status).c_str(), stacked_stasis);
                         }
 #endif
                     }
                 }
-                for (CardStatus * status : fd->tap->assaults.m_indirect)
+                for (CardStatus & status : fd->tap->assaults)
                 {
-                    if (status->m_faction == played_status->m_faction)
+                    if (status.m_faction == played_status->m_faction)
                     {
-                        stacked_stasis += status->skill(Skill::stasis);
+                        stacked_stasis += status.skill(Skill::stasis);
 #ifndef NDEBUG
-                        if (status->skill(Skill::stasis) > 0)
+                        if (status.skill(Skill::stasis) > 0)
                         {
                             _DEBUG_MSG(2, "+ Stasis [%s]: stacks +%u stasis protection from %s (total stacked: %u)\n",
-                                faction_names[played_status->m_faction].c_str(), status->skill(Skill::stasis),
+                                faction_names[played_status->m_faction].c_str(), status.skill(Skill::stasis),
                                 status_description(played_status).c_str(), stacked_stasis);
                         }
 #endif
-                        if (fd->bg_effects.count(PassiveBGE::temporalbacklash) && status->skill(Skill::counter))
+                        if (play_has_bg_effect<passive_bges>(fd, PassiveBGE::temporalbacklash) && status.skill(Skill::counter))
                         {
-                            stacked_stasis += (status->skill(Skill::counter) + 1) / 2;
+                            stacked_stasis += (status.skill(Skill::counter) + 1) / 2;
 #ifndef NDEBUG
                             _DEBUG_MSG(2, "Temporal Backlash: + Stasis [%s]: stacks +%u stasis protection from %s (total stacked: %u)\n",
-                                faction_names[played_status->m_faction].c_str(), (status->skill(Skill::counter) + 1) / 2,
+                                faction_names[played_status->m_faction].c_str(), (status.skill(Skill::counter) + 1) / 2,
                                 status_description(played_status).c_str(), stacked_stasis);
 #endif
                         }
@@ -2380,20 +2533,20 @@ Results<uint64_t> play(Field* fd)
         if(__builtin_expect(fd->end, false)) { break; }
 
         // Evaluate Heroism BGE skills
-        if (fd->bg_effects.count(PassiveBGE::heroism))
+        if (play_has_bg_effect<passive_bges>(fd, PassiveBGE::heroism))
         {
-            for (CardStatus * dst: fd->tap->assaults.m_indirect)
+            for (CardStatus & dst : fd->tap->assaults)
             {
-                unsigned bge_value = (dst->skill(Skill::valor) + 1) / 2;
+                unsigned bge_value = (dst.skill(Skill::valor) + 1) / 2;
                 if (bge_value <= 0)
                 { continue; }
                 SkillSpec ss_protect{Skill::protect, bge_value, allfactions, 0, 0, Skill::no_skill, Skill::no_skill, false,};
-                if (dst->m_inhibited > 0)
+                if (dst.m_inhibited > 0)
                 {
                     _DEBUG_MSG(1, "Heroism: %s on %s but it is inhibited\n",
-                        skill_short_description(ss_protect).c_str(), status_description(dst).c_str());
-                    -- dst->m_inhibited;
-                    if (fd->bg_effects.count(PassiveBGE::divert))
+                        skill_short_description(ss_protect).c_str(), status_description(&dst).c_str());
+                    -- dst.m_inhibited;
+                    if (play_has_bg_effect<passive_bges>(fd, PassiveBGE::divert))
                     {
                         SkillSpec diverted_ss = ss_protect;
                         diverted_ss.y = allfactions;
@@ -2419,37 +2572,36 @@ Results<uint64_t> play(Field* fd)
                     }
                     continue;
                 }
-#ifndef NQUEST
                 bool has_counted_quest = false;
-#endif
-                check_and_perform_skill<Skill::protect>(fd, &fd->tap->commander, dst, ss_protect, false
-#ifndef NQUEST
-                    , has_counted_quest
-#endif
-                );
+                check_and_perform_skill<Skill::protect, quest>(fd, &fd->tap->commander, &dst, ss_protect, false, has_counted_quest);
             }
         }
 
         // Evaluate activation BGE skills
         for (const auto & bg_skill: fd->bg_skills[fd->tapi])
         {
+            TUO_PROFILE_PHASE(fd, bge_skills);
             fd->prepare_action();
             _DEBUG_MSG(2, "Evaluating BG skill %s\n", skill_description(bg_skill).c_str());
-            fd->skill_queue.emplace_back(&fd->tap->commander, bg_skill);
-            resolve_skill(fd);
+            fd->skill_queue.push_back({&fd->tap->commander, &bg_skill});
+            resolve_skill<quest>(fd);
             fd->finalize_action();
         }
         if (__builtin_expect(fd->end, false)) { break; }
 
         // Evaluate commander
         fd->current_phase = Field::commander_phase;
-        evaluate_skills<CardType::commander>(fd, &fd->tap->commander, fd->tap->commander.m_card->m_skills);
+        {
+            TUO_PROFILE_PHASE(fd, commander);
+            evaluate_skills<CardType::commander, quest>(fd, &fd->tap->commander, fd->tap->commander.m_card->m_activation_skills);
+        }
         if(__builtin_expect(fd->end, false)) { break; }
 
         // Evaluate structures
         fd->current_phase = Field::structures_phase;
         for(fd->current_ci = 0; !fd->end && fd->current_ci < fd->tap->structures.size(); ++fd->current_ci)
         {
+            TUO_PROFILE_PHASE(fd, structures);
             CardStatus* current_status(&fd->tap->structures[fd->current_ci]);
             if (!is_active(current_status))
             {
@@ -2457,7 +2609,7 @@ Results<uint64_t> play(Field* fd)
             }
             else
             {
-                evaluate_skills<CardType::structure>(fd, current_status, current_status->m_card->m_skills);
+                evaluate_skills<CardType::structure, quest>(fd, current_status, current_status->m_card->m_activation_skills);
             }
         }
         // Evaluate assaults
@@ -2465,6 +2617,7 @@ Results<uint64_t> play(Field* fd)
         fd->bloodlust_value = 0;
         for(fd->current_ci = 0; !fd->end && fd->current_ci < fd->tap->assaults.size(); ++fd->current_ci)
         {
+            TUO_PROFILE_PHASE(fd, assaults);
             // ca: current assault
             CardStatus* current_status(&fd->tap->assaults[fd->current_ci]);
             // aa: across assault
@@ -2475,7 +2628,7 @@ Results<uint64_t> play(Field* fd)
                 _DEBUG_MSG(2, "%s cannot take action.\n", status_description(current_status).c_str());
                 // evals Halted Orders BGE
                 unsigned inhibit_value;
-                if (fd->bg_effects.count(PassiveBGE::haltedorders) && (current_status->m_delay > 0) && across_status && is_alive(across_status)
+                if (play_has_bg_effect<passive_bges>(fd, PassiveBGE::haltedorders) && (current_status->m_delay > 0) && across_status && is_alive(across_status)
                     && (inhibit_value = current_status->skill(Skill::inhibit)) > across_status->m_inhibited)
                 {
                     _DEBUG_MSG(1, "Halted Orders: %s inhibits %s by %u\n",
@@ -2495,7 +2648,7 @@ Results<uint64_t> play(Field* fd)
                 current_status->m_protected_stasis = 0;
                 fd->assault_bloodlusted = false;
                 current_status->m_step = CardStep::attacking;
-                evaluate_skills<CardType::assault>(fd, current_status, current_status->m_card->m_skills, &attacked);
+                evaluate_skills<CardType::assault, quest>(fd, current_status, current_status->m_card->m_activation_skills, &attacked);
                 if (__builtin_expect(fd->end, false)) { break; }
             }
             if (current_status->m_corroded_rate > 0)
@@ -2516,40 +2669,41 @@ Results<uint64_t> play(Field* fd)
             current_status->m_step = CardStep::attacked;
         }
         fd->current_phase = Field::end_phase;
-        turn_end_phase(fd);
+        turn_end_phase<quest>(fd);
         if(__builtin_expect(fd->end, false)) { break; }
         _DEBUG_MSG(1, "TURN %u ends for %s\n", fd->turn, status_description(&fd->tap->commander).c_str());
         std::swap(fd->tapi, fd->tipi);
         std::swap(fd->tap, fd->tip);
         ++fd->turn;
     }
+}
+//------------------------------------------------------------------------------
+template<OptimizationMode optimization_mode>
+Results<uint64_t> battle_results(Field* fd)
+{
     const auto & p = fd->players;
     unsigned raid_damage = 0;
-#ifndef NQUEST
     unsigned quest_score = 0;
-#endif
-    switch (fd->optimization_mode)
+    switch (optimization_mode)
     {
         case OptimizationMode::raid:
             raid_damage = 15
                 + (std::min<unsigned>(p[1]->deck->deck_size, (fd->turn + 1) / 2) - p[1]->assaults.size() - p[1]->structures.size())
                 - (10 * p[1]->commander.m_hp / p[1]->commander.m_max_hp);
             break;
-#ifndef NQUEST
         case OptimizationMode::quest:
             if (fd->quest.quest_type == QuestType::card_survival)
             {
-                for (const auto & status: p[0]->assaults.m_indirect)
-                { fd->quest_counter += (fd->quest.quest_key == status->m_card->m_id); }
-                for (const auto & status: p[0]->structures.m_indirect)
-                { fd->quest_counter += (fd->quest.quest_key == status->m_card->m_id); }
+                for (CardStatus & status : p[0]->assaults)
+                { fd->quest_counter += (fd->quest.quest_key == status.m_card->m_id); }
+                for (CardStatus & status : p[0]->structures)
+                { fd->quest_counter += (fd->quest.quest_key == status.m_card->m_id); }
                 for (const auto & card: p[0]->deck->shuffled_cards)
                 { fd->quest_counter += (fd->quest.quest_key == card->m_id); }
             }
             quest_score = fd->quest.must_fulfill ? (fd->quest_counter >= fd->quest.quest_value ? fd->quest.quest_score : 0) : std::min<unsigned>(fd->quest.quest_score, fd->quest.quest_score * fd->quest_counter / fd->quest.quest_value);
             _DEBUG_MSG(1, "Quest: %u / %u = %u%%.\n", fd->quest_counter, fd->quest.quest_value, quest_score);
             break;
-#endif
         default:
             break;
     }
@@ -2557,7 +2711,7 @@ Results<uint64_t> play(Field* fd)
     if(!is_alive(&fd->players[0]->commander))
     {
         _DEBUG_MSG(1, "You lose.\n");
-        switch (fd->optimization_mode)
+        switch (optimization_mode)
         {
         case OptimizationMode::raid: return {0, 0, 1, raid_damage};
         case OptimizationMode::brawl: return {0, 0, 1, 5};
@@ -2567,9 +2721,7 @@ Results<uint64_t> play(Field* fd)
                 unsigned max_score = max_possible_score[(size_t)OptimizationMode::brawl_defense];
                 return {0, 0, 1, max_score - enemy_brawl_score};
             }
-#ifndef NQUEST
         case OptimizationMode::quest: return {0, 0, 1, fd->quest.must_win ? 0 : quest_score};
-#endif
         default: return {0, 0, 1, 0};
         }
     }
@@ -2577,7 +2729,7 @@ Results<uint64_t> play(Field* fd)
     if(!is_alive(&fd->players[1]->commander))
     {
         _DEBUG_MSG(1, "You win.\n");
-        switch (fd->optimization_mode)
+        switch (optimization_mode)
         {
         case OptimizationMode::brawl:
             {
@@ -2595,9 +2747,7 @@ Results<uint64_t> play(Field* fd)
                 unsigned campaign_score = 100 - 10 * (std::min<unsigned>(p[0]->deck->cards.size(), (fd->turn + 1) / 2) - p[0]->assaults.size() - p[0]->structures.size());
                 return {1, 0, 0, campaign_score};
             }
-#ifndef NQUEST
         case OptimizationMode::quest: return {1, 0, 0, fd->quest.win_score + quest_score};
-#endif
         default:
             return {1, 0, 0, 100};
         }
@@ -2605,7 +2755,7 @@ Results<uint64_t> play(Field* fd)
     if (fd->turn > turn_limit)
     {
         _DEBUG_MSG(1, "Stall after %u turns.\n", turn_limit);
-        switch (fd->optimization_mode)
+        switch (optimization_mode)
         {
         case OptimizationMode::defense: return {0, 1, 0, 100};
         case OptimizationMode::raid: return {0, 1, 0, raid_damage};
@@ -2616,9 +2766,7 @@ Results<uint64_t> play(Field* fd)
                 //unsigned min_score = min_possible_score[(size_t)OptimizationMode::brawl_defense];
                 return {1, 0, 0, /* max_score - min_score */ 67 - 5};
             }
-#ifndef NQUEST
         case OptimizationMode::quest: return {0, 1, 0, fd->quest.must_win ? 0 : quest_score};
-#endif
         default: return {0, 1, 0, 0};
         }
     }
@@ -2628,24 +2776,72 @@ Results<uint64_t> play(Field* fd)
     return {0, 0, 0, 0};
 }
 //------------------------------------------------------------------------------
+// Only the quest optimization mode counts quest progress (fd->inc_counter()).
+template<gamemode_t gamemode, OptimizationMode optimization_mode, bool passive_bges>
+Results<uint64_t> play_variant(Field* fd)
+{
+    play_turns<gamemode, passive_bges, optimization_mode == OptimizationMode::quest>(fd);
+    return(battle_results<optimization_mode>(fd));
+}
+//------------------------------------------------------------------------------
+template<OptimizationMode optimization_mode>
+PlayFunction select_play(gamemode_t gamemode, bool passive_bges)
+{
+    if (gamemode == surge)
+    { return(passive_bges ? play_variant<surge, optimization_mode, true> : play_variant<surge, optimization_mode, false>); }
+    return(passive_bges ? play_variant<fight, optimization_mode, true> : play_variant<fight, optimization_mode, false>);
+}
+//------------------------------------------------------------------------------
+PlayFunction select_play(gamemode_t gamemode, OptimizationMode optimization_mode, bool passive_bges)
+{
+    switch (optimization_mode)
+    {
+    case OptimizationMode::notset: return(select_play<OptimizationMode::notset>(gamemode, passive_bges));
+    case OptimizationMode::winrate: return(select_play<OptimizationMode::winrate>(gamemode, passive_bges));
+    case OptimizationMode::defense: return(select_play<OptimizationMode::defense>(gamemode, passive_bges));
+    case OptimizationMode::war: return(select_play<OptimizationMode::war>(gamemode, passive_bges));
+    case OptimizationMode::brawl: return(select_play<OptimizationMode::brawl>(gamemode, passive_bges));
+    case OptimizationMode::brawl_defense: return(select_play<OptimizationMode::brawl_defense>(gamemode, passive_bges));
+    case OptimizationMode::raid: return(select_play<OptimizationMode::raid>(gamemode, passive_bges));
+    case OptimizationMode::campaign: return(select_play<OptimizationMode::campaign>(gamemode, passive_bges));
+    case OptimizationMode::quest: return(select_play<OptimizationMode::quest>(gamemode, passive_bges));
+    default:
+        assert(false);
+        return(nullptr);
+    }
+}
+//------------------------------------------------------------------------------
+Results<uint64_t> play(Field* fd)
+{
+    TUO_PROFILE_PHASE(fd, battle);
+    return(fd->play_variant(fd));
+}
+//------------------------------------------------------------------------------
+template<bool quest>
+void fill_skill_table(SkillFunction (&table)[Skill::num_skills])
+{
+    memset(table, 0, sizeof table);
+    table[Skill::mortar] = perform_targetted_hostile_fast<Skill::mortar, quest>;
+    table[Skill::enfeeble] = perform_targetted_hostile_fast<Skill::enfeeble, quest>;
+    table[Skill::enhance] = perform_targetted_allied_fast<Skill::enhance, quest>;
+    table[Skill::evolve] = perform_targetted_allied_fast<Skill::evolve, quest>;
+    table[Skill::heal] = perform_targetted_allied_fast<Skill::heal, quest>;
+    table[Skill::jam] = perform_targetted_hostile_fast<Skill::jam, quest>;
+    table[Skill::mend] = perform_targetted_allied_fast<Skill::mend, quest>;
+    table[Skill::overload] = perform_targetted_allied_fast<Skill::overload, quest>;
+    table[Skill::protect] = perform_targetted_allied_fast<Skill::protect, quest>;
+    table[Skill::rally] = perform_targetted_allied_fast<Skill::rally, quest>;
+    table[Skill::enrage] = perform_targetted_allied_fast<Skill::enrage, quest>;
+    table[Skill::rush] = perform_targetted_allied_fast_rush<quest>;
+    table[Skill::siege] = perform_targetted_hostile_fast<Skill::siege, quest>;
+    table[Skill::strike] = perform_targetted_hostile_fast<Skill::strike, quest>;
+    table[Skill::sunder] = perform_targetted_hostile_fast<Skill::sunder, quest>;
+    table[Skill::weaken] = perform_targetted_hostile_fast<Skill::weaken, quest>;
+    table[Skill::mimic] = perform_targetted_hostile_fast<Skill::mimic, quest>;
+}
+
 void fill_skill_table()
 {
-    memset(skill_table, 0, sizeof skill_table);
-    skill_table[Skill::mortar] = perform_targetted_hostile_fast<Skill::mortar>;
-    skill_table[Skill::enfeeble] = perform_targetted_hostile_fast<Skill::enfeeble>;
-    skill_table[Skill::enhance] = perform_targetted_allied_fast<Skill::enhance>;
-    skill_table[Skill::evolve] = perform_targetted_allied_fast<Skill::evolve>;
-    skill_table[Skill::heal] = perform_targetted_allied_fast<Skill::heal>;
-    skill_table[Skill::jam] = perform_targetted_hostile_fast<Skill::jam>;
-    skill_table[Skill::mend] = perform_targetted_allied_fast<Skill::mend>;
-    skill_table[Skill::overload] = perform_targetted_allied_fast<Skill::overload>;
-    skill_table[Skill::protect] = perform_targetted_allied_fast<Skill::protect>;
-    skill_table[Skill::rally] = perform_targetted_allied_fast<Skill::rally>;
-    skill_table[Skill::enrage] = perform_targetted_allied_fast<Skill::enrage>;
-    skill_table[Skill::rush] = perform_targetted_allied_fast_rush;
-    skill_table[Skill::siege] = perform_targetted_hostile_fast<Skill::siege>;
-    skill_table[Skill::strike] = perform_targetted_hostile_fast<Skill::strike>;
-    skill_table[Skill::sunder] = perform_targetted_hostile_fast<Skill::sunder>;
-    skill_table[Skill::weaken] = perform_targetted_hostile_fast<Skill::weaken>;
-    skill_table[Skill::mimic] = perform_targetted_hostile_fast<Skill::mimic>;
+    fill_skill_table<false>(skill_table);
+    fill_skill_table<true>(quest_skill_table);
 }
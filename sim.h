@@ -1,7 +1,6 @@
 #ifndef SIM_H_INCLUDED
 #define SIM_H_INCLUDED
 
-#include <boost/pool/pool.hpp>
 #include <string>
 #include <array>
 #include <deque>
@@ -12,6 +11,7 @@
 #include <random>
 
 #include "tyrant.h"
+#include "profile.h"
 
 class Card;
 class Cards;
@@ -56,74 +56,212 @@ struct FinalResults
     result_type points;
     result_type points_lower_bound;
     result_type points_upper_bound;
+    result_type points_standard_error;  // arithmetic mean of the points only
     uint64_t n_sims;
 };
 
 void fill_skill_table();
+// play() runs the variant of the Field, specialised for its gamemode, optimization mode and whether it has passive BGE.
+typedef Results<uint64_t> (*PlayFunction)(Field* fd);
+PlayFunction select_play(gamemode_t gamemode, OptimizationMode optimization_mode, bool passive_bges);
 Results<uint64_t> play(Field* fd);
-// Pool-based indexed storage.
-//---------------------- Pool-based indexed storage ----------------------------
+//---------------------- Inline indexed storage --------------------------------
+// The units of one side of the board, kept in board order in a fixed-capacity
+// array. Units stay in place while on the board; remove() compacts the
+// survivors to the front, so only call it when no CardStatus* is held.
+// A side holds at most its dominions, its forts and one card per turn of its
+// own; tyrant_optimize checks the decks against max_board_units when it loads them.
+const unsigned max_board_units = 32;
 template<typename T>
 class Storage
 {
 public:
-    typedef typename std::vector<T*>::size_type size_type;
+    typedef unsigned size_type;
     typedef T value_type;
-    Storage(size_type size) :
-        m_pool(sizeof(T))
+    static_assert(max_board_units <= 64, "remove() tracks units in a 64-bit mask");
+
+    Storage() :
+        m_size(0)
     {
-        m_indirect.reserve(size);
     }
 
     inline T& operator[](size_type i)
     {
-        return(*m_indirect[i]);
+        return(m_units[i]);
     }
 
+    inline T* begin() { return(m_units); }
+    inline T* end() { return(m_units + m_size); }
+
     inline T& add_back()
     {
-        m_indirect.emplace_back((T*) m_pool.malloc());
-        return(*m_indirect.back());
+        assert(m_size < max_board_units);
+        return(m_units[m_size ++]);
     }
 
     template<typename Pred>
     void remove(Pred p)
     {
+        uint64_t alive_mask(0);
+        for(size_type current(0); current < m_size; ++current)
+        {
+            alive_mask |= uint64_t(!p(m_units[current])) << current;
+        }
+        if(alive_mask == (uint64_t(1) << m_size) - 1)
+        {
+            return;
+        }
         size_type head(0);
-        for(size_type current(0); current < m_indirect.size(); ++current)
+        for(; alive_mask; alive_mask &= alive_mask - 1, ++head)
         {
-            if(p((*this)[current]))
-            {
-                m_pool.free(m_indirect[current]);
-            }
-            else
+            size_type current(__builtin_ctzll(alive_mask));
+            if(current != head)
             {
-                if(current != head)
-                {
-                    m_indirect[head] = m_indirect[current];
-                }
-                ++head;
+                m_units[head] = m_units[current];
             }
         }
-        m_indirect.erase(m_indirect.begin() + head, m_indirect.end());
+        m_size = head;
     }
 
     void reset()
     {
-        for(auto index: m_indirect)
+        m_size = 0;
+    }
+
+    inline size_type size() const
+    {
+        return(m_size);
+    }
+
+    inline size_type capacity() const
+    {
+        return(max_board_units);
+    }
+
+private:
+    size_type m_size;
+    T m_units[max_board_units];
+};
+//---------------------- Double-ended ring buffer -------------------------------
+// Capacity is a power of 2 given at construction; it is doubled only if ever exceeded.
+template<typename T>
+class RingDeque
+{
+public:
+    typedef unsigned size_type;
+    RingDeque(size_type min_capacity) :
+        m_head(0),
+        m_size(0)
+    {
+        size_type capacity(1);
+        while(capacity < min_capacity) { capacity *= 2; }
+        m_data.resize(capacity);
+    }
+
+    inline bool empty() const { return(m_size == 0); }
+    inline size_type size() const { return(m_size); }
+    inline void clear() { m_head = 0; m_size = 0; }
+    inline T& front() { return(m_data[m_head]); }
+    inline T& back() { return(m_data[(m_head + m_size - 1) & mask()]); }
+
+    inline void pop_front()
+    {
+        m_head = (m_head + 1) & mask();
+        --m_size;
+    }
+
+    inline void pop_back()
+    {
+        --m_size;
+    }
+
+    inline void push_back(const T& x)
+    {
+        if(__builtin_expect(m_size == m_data.size(), false)) { grow(); }
+        m_data[(m_head + m_size) & mask()] = x;
+        ++m_size;
+    }
+
+    inline void push_front(const T& x)
+    {
+        if(__builtin_expect(m_size == m_data.size(), false)) { grow(); }
+        m_head = (m_head - 1) & mask();
+        m_data[m_head] = x;
+        ++m_size;
+    }
+
+    // Move the last n elements to the front, keeping their order.
+    inline void move_back_to_front(size_type n)
+    {
+        for(; n > 0; --n)
         {
-            m_pool.free(index);
+            T x(back());
+            pop_back();
+            push_front(x);
         }
-        m_indirect.clear();
     }
 
-    inline size_type size() const
+private:
+    inline size_type mask() const { return(m_data.size() - 1); }
+
+    void grow()
+    {
+        std::vector<T> data(m_data.size() * 2);
+        for(size_type i(0); i < m_size; ++i)
+        {
+            data[i] = m_data[(m_head + i) & mask()];
+        }
+        m_data.swap(data);
+        m_head = 0;
+    }
+
+    std::vector<T> m_data;
+    size_type m_head;
+    size_type m_size;
+};
+//---------------------- Fixed-capacity vector ---------------------------------
+// The subset of std::vector used by the per-action unit lists of the Field,
+// on an inline array so that a battle never allocates. push_back() only asserts
+// the capacity: each list is sized from max_board_units for the most units it
+// can hold, and the decks are checked against max_board_units at load time.
+template<typename T, unsigned N>
+class FixedVector
+{
+public:
+    typedef unsigned size_type;
+    typedef T value_type;
+
+    FixedVector() :
+        m_size(0)
+    {
+    }
+
+    inline T& operator[](size_type i) { return(m_data[i]); }
+    inline const T& operator[](size_type i) const { return(m_data[i]); }
+    inline T* begin() { return(m_data); }
+    inline T* end() { return(m_data + m_size); }
+    inline const T* begin() const { return(m_data); }
+    inline const T* end() const { return(m_data + m_size); }
+    inline bool empty() const { return(m_size == 0); }
+    inline size_type size() const { return(m_size); }
+    inline void clear() { m_size = 0; }
+
+    inline void push_back(const T& x)
+    {
+        assert(m_size < N);
+        m_data[m_size ++] = x;
+    }
+
+    // shrink only
+    inline void resize(size_type n)
     {
-        return(m_indirect.size());
+        assert(n <= m_size);
+        m_size = n;
     }
 
-    std::vector<T*> m_indirect;
-    boost::pool<> m_pool;
+private:
+    size_type m_size;
+    T m_data[N];
 };
 //------------------------------------------------------------------------------
 enum class CardStep
@@ -163,17 +301,30 @@ struct CardStatus
     bool m_rush_attempted;
     bool m_sundered;
     unsigned m_weakened;
-
-    signed m_primary_skill_offset[Skill::num_skills];
-    signed m_evolved_skill_offset[Skill::num_skills];
-    unsigned m_enhanced_value[Skill::num_skills];
-    unsigned m_skill_cd[Skill::num_skills];
+    unsigned m_damaged_times; // in the action Field::action_index, for barrier
+    unsigned m_damaged_action;
+
+    // Per-skill state indexed by skill slot (see Card::m_skill_slot). Slot 0 is shared by
+    // the skills the card does not have and reads as zero; evolve may track such a skill
+    // in one of the extra slots following the card's own.
+    bool m_skills_modified; // evolved or enhanced since the last reset_skill_slots()
+    unsigned m_num_extra_skills;
+    uint8_t m_extra_skill_ids[max_skill_slots];
+    int8_t m_primary_skill_offset[max_skill_slots];
+    int8_t m_evolved_skill_offset[max_skill_slots];
+    unsigned m_enhanced_value[max_skill_slots];
+    unsigned m_skill_cd[max_skill_slots];
+    static_assert(Skill::num_skills <= 128, "skill offsets must fit in int8_t");
 
     CardStatus() {}
 
     void set(const Card* card);
     void set(const Card& card);
     std::string description() const;
+    inline unsigned skill_slot(Skill::Skill skill_id) const;
+    unsigned track_skill(Skill::Skill skill_id);
+    void reset_skill_slots();
+    inline Skill::Skill primary_skill(Skill::Skill skill_id) const;
     inline unsigned skill_base_value(Skill::Skill skill_id) const;
     unsigned skill(Skill::Skill skill_id) const;
     bool has_skill(Skill::Skill skill_id) const;
@@ -189,14 +340,19 @@ public:
 
     Hand(Deck* deck_) :
         deck(deck_),
-        assaults(15),
-        structures(15),
+        assaults(),
+        structures(),
         stasis_faction_bitmap(0),
-        total_cards_destroyed(0)
+        total_cards_destroyed(0),
+        alive_factions_bitmap(0),
+        alive_walls_mask(0)
     {
     }
 
-    void reset(std::mt19937& re);
+    void reset(RandomEngine& re);
+    inline void count_alive(const CardStatus* status);
+    inline void count_dead(const CardStatus* status);
+    inline void recount_walls();
 
     Deck* deck;
     CardStatus commander;
@@ -204,9 +360,12 @@ public:
     Storage<CardStatus> structures;
     unsigned stasis_faction_bitmap;
     unsigned total_cards_destroyed;
+    // Aggregates over the alive units, kept up to date by PlayCard, remove_hp and remove_dead
+    unsigned alive_faction_count[num_factions];  // alive assaults of each card faction
+    unsigned alive_factions_bitmap;  // bit #f: alive_faction_count[f] > 0 (Coalition)
+    uint64_t alive_walls_mask;  // bit #i: structures[i] is an alive wall
 };
 
-#ifndef NQUEST
 struct Quest
 {
     QuestType::QuestType quest_type;
@@ -227,8 +386,9 @@ struct Quest
         must_win(false)
     {}
 };
-#endif
 
+// the alive assaults up to 2 slots (Critical Reach) on each side of a unit
+typedef FixedVector<CardStatus*, 4> AdjacentAssaults;
 //------------------------------------------------------------------------------
 // struct Field is the data model of a battle:
 // an attacker and a defender deck, list of assaults and structures, etc.
@@ -236,7 +396,7 @@ class Field
 {
 public:
     bool end;
-    std::mt19937& re;
+    RandomEngine& re;
     const Cards& cards;
     // players[0]: the attacker, players[1]: the defender
     std::array<Hand*, 2> players;
@@ -244,20 +404,26 @@ public:
     unsigned tipi; // and inactive
     Hand* tap;
     Hand* tip;
-    std::vector<CardStatus*> selection_array;
+    FixedVector<CardStatus*, max_board_units> selection_array;  // targets are taken from one Storage
     unsigned turn;
     gamemode_t gamemode;
     OptimizationMode optimization_mode;
-#ifndef NQUEST
     const Quest quest;
-#endif
-    std::unordered_map<unsigned, unsigned> bg_effects; // passive BGE
+    std::array<unsigned, PassiveBGE::num_passive_bges> bg_effects; // passive BGE values
+    unsigned bg_effects_mask; // bit #i: passive BGE #i is active
+    PlayFunction play_variant;
     std::vector<SkillSpec> bg_skills[2]; // active BGE, casted every turn
     // With the introduction of on death skills, a single skill can trigger arbitrary many skills.
     // They are stored in this, and cleared after all have been performed.
-    std::deque<std::tuple<CardStatus*, SkillSpec>> skill_queue;
-    std::vector<CardStatus*> killed_units;
-    std::unordered_map<CardStatus*, unsigned> damaged_units_to_times;
+    // The skills are not copied: they live in the cards, in bg_skills or in revenge_skills.
+    RingDeque<std::pair<CardStatus*, const SkillSpec*>> skill_queue;
+    std::array<SkillSpec, 2> revenge_skills; // on death skills of passive BGE Revenge (heal, rally)
+    // a unit dies once, so at most every unit of both sides is killed before the list is cleared
+    FixedVector<CardStatus*, 2 * max_board_units> killed_units;
+    // units damaged during the current action (their m_damaged_times is valid), for barrier:
+    // each unit of both sides and the two commanders at most once
+    FixedVector<CardStatus*, 2 * max_board_units + 2> damaged_units;
+    unsigned action_index;
 
     enum phase
     {
@@ -276,14 +442,13 @@ public:
 
     bool assault_bloodlusted;
     unsigned bloodlust_value;
-#ifndef NQUEST
     unsigned quest_counter;
+#ifdef TUO_PROFILE
+    BattleProfile profile;  // accumulated over all the battles of this Field
 #endif
 
-    Field(std::mt19937& re_, const Cards& cards_, Hand& hand1, Hand& hand2, gamemode_t gamemode_, OptimizationMode optimization_mode_,
-#ifndef NQUEST
+    Field(RandomEngine& re_, const Cards& cards_, Hand& hand1, Hand& hand2, gamemode_t gamemode_, OptimizationMode optimization_mode_,
             const Quest & quest_,
-#endif
             std::unordered_map<unsigned, unsigned>& bg_effects_, std::vector<SkillSpec>& your_bg_skills_, std::vector<SkillSpec>& enemy_bg_skills_) :
         end{false},
         re(re_),
@@ -292,22 +457,54 @@ public:
         turn(1),
         gamemode(gamemode_),
         optimization_mode(optimization_mode_),
-#ifndef NQUEST
         quest(quest_),
-#endif
-        bg_effects{bg_effects_},
+        bg_effects(),
+        bg_effects_mask(0),
+        play_variant(select_play(gamemode_, optimization_mode_, !bg_effects_.empty())),
         bg_skills{your_bg_skills_, enemy_bg_skills_},
+        // the skill being resolved, plus 2 Revenge skills per unit on the board
+        skill_queue(1 + 2 * (2 + hand1.assaults.capacity() + hand1.structures.capacity()
+                    + hand2.assaults.capacity() + hand2.structures.capacity())),
+        action_index(0),
         assault_bloodlusted(false),
         bloodlust_value(0)
-#ifndef NQUEST
         , quest_counter(0)
-#endif
     {
+        static_assert(PassiveBGE::num_passive_bges <= sizeof(bg_effects_mask) * 8, "bg_effects_mask is too narrow");
+        for (const auto & bg_effect: bg_effects_)
+        {
+            bg_effects[bg_effect.first] = bg_effect.second;
+            bg_effects_mask |= 1u << bg_effect.first;
+        }
+        revenge_skills = {{
+            {Skill::heal, bg_effects[PassiveBGE::revenge], allfactions, 0, 0, Skill::no_skill, Skill::no_skill, true,},
+            {Skill::rally, bg_effects[PassiveBGE::revenge], allfactions, 0, 0, Skill::no_skill, Skill::no_skill, true,},
+        }};
+    }
+
+    // Prepare a new battle between the same hands. The containers keep their capacity.
+    void reset()
+    {
+        end = false;
+        turn = 1;
+        selection_array.clear();
+        skill_queue.clear();
+        killed_units.clear();
+        damaged_units.clear();
+        action_index = 0;
+        assault_bloodlusted = false;
+        bloodlust_value = 0;
+        quest_counter = 0;
+    }
+
+    inline bool has_bg_effect(PassiveBGE::PassiveBGE bge) const
+    {
+        return(bg_effects_mask & (1u << bge));
     }
 
     inline unsigned rand(unsigned x, unsigned y)
     {
-        return(std::uniform_int_distribution<unsigned>(x, y)(re));
+        return(random_in_range(re, x, y));
     }
 
     inline unsigned flip()
@@ -328,13 +525,12 @@ public:
     inline CardStatus * left_assault(const CardStatus * status, const unsigned n);
     inline CardStatus * right_assault(const CardStatus * status);
     inline CardStatus * right_assault(const CardStatus * status, const unsigned n);
-    inline const std::vector<CardStatus *> adjacent_assaults(const CardStatus * status);
-    inline const std::vector<CardStatus *> adjacent_assaults(const CardStatus * status, const unsigned n);
+    inline const AdjacentAssaults adjacent_assaults(const CardStatus * status);
+    inline const AdjacentAssaults adjacent_assaults(const CardStatus * status, const unsigned n);
     inline void print_selection_array();
     inline void prepare_action();
     inline void finalize_action();
 
-#ifndef NQUEST
     inline void inc_counter(QuestType::QuestType quest_type, unsigned quest_key, unsigned quest_2nd_key = 0, unsigned value = 1)
     {
         if (quest.quest_type == quest_type && quest.quest_key == quest_key && (quest.quest_2nd_key == 0 || quest.quest_2nd_key == quest_2nd_key))
@@ -342,7 +538,6 @@ public:
             quest_counter += value;
         }
     }
-#endif
 };
 
 #endif
@@ -32,6 +32,43 @@ const std::string skill_names[Skill::num_skills] =
     "Allegiance", "Flurry", "Valor", "Stasis",
 };
 
+namespace {
+const uint8_t harmful = SkillClass::activation_harmful | SkillClass::activation_hostile;
+const uint8_t hostile = SkillClass::activation_hostile;
+const uint8_t helpful = SkillClass::activation_helpful;
+const uint8_t with_x = SkillClass::activation_with_x;
+}
+
+const uint8_t skill_classes[Skill::num_skills] =
+{
+    // Placeholder for no-skill:
+    0,
+
+    // Activation (harmful): Enfeeble, Jam, Mortar, Siege, Strike, Sunder, Weaken
+    harmful | with_x, harmful, harmful | with_x, harmful | with_x, harmful | with_x, harmful | with_x, harmful | with_x,
+
+    // Activation (helpful): Enhance, Evolve, Heal, Mend, Overload, Protect, Rally, Enrage, Rush
+    helpful | with_x, helpful, helpful | with_x, helpful | with_x, helpful, helpful | with_x, helpful | with_x, helpful | with_x, helpful | with_x,
+
+    // Activation (unclassified/polymorphic): Mimic
+    hostile | with_x,
+
+    // Defensive: Armor, Avenge, Corrosive, Counter, Evade, Payback, Revenge, Refresh, Wall, Barrier
+    SkillClass::defensive, SkillClass::defensive, SkillClass::defensive, SkillClass::defensive, SkillClass::defensive,
+    SkillClass::defensive, SkillClass::defensive, SkillClass::defensive, SkillClass::defensive, 0,
+
+    // Combat-Modifier: Coalition, Legion, Pierce, Rupture, Swipe, Drain, Venom
+    0, SkillClass::combat_modifier, SkillClass::combat_modifier, SkillClass::combat_modifier,
+    SkillClass::combat_modifier, SkillClass::combat_modifier, SkillClass::combat_modifier,
+
+    // Damage-Dependant: Berserk, Inhibit, Sabotage, Leech, Poison
+    SkillClass::damage_dependent, SkillClass::damage_dependent, SkillClass::damage_dependent,
+    SkillClass::damage_dependent, SkillClass::damage_dependent,
+
+    // Triggered: Allegiance, Flurry, Valor, Stasis
+    SkillClass::triggered, SkillClass::triggered, SkillClass::triggered, 0,
+};
+
 const std::string passive_bge_names[PassiveBGE::num_passive_bges] =
 {
     // Placeholder for no-bge:
@@ -50,16 +87,8 @@ const std::string rarity_names[]{"", "common", "rare", "epic", "legend", "vindi"
 unsigned const upgrade_cost[]{0, 5, 15, 30, 75, 150};
 unsigned const salvaging_income[][7]{{}, {0, 1, 2, 5}, {0, 5, 10, 15, 20}, {0, 20, 25, 30, 40, 50, 65}, {0, 40, 45, 60, 75, 100, 125}, {0, 80, 85, 100, 125, 175, 250}};
 
-unsigned min_possible_score[]{0, 0, 0, 10, 5, 5, 5, 0
-#ifndef NQUEST
-, 0
-#endif
-};
-unsigned max_possible_score[]{100, 100, 100, 100, 65, 65, 100, 100
-#ifndef NQUEST
-, 100
-#endif
-};
+unsigned min_possible_score[]{0, 0, 0, 10, 5, 5, 5, 0, 0};
+unsigned max_possible_score[]{100, 100, 100, 100, 65, 65, 100, 100, 100};
 
 std::string decktype_names[DeckType::num_decktypes]{"Deck", "Mission", "Raid", "Campaign", "Custom Deck", };
 
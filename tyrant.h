@@ -3,6 +3,8 @@
 
 #define TYRANT_OPTIMIZER_VERSION "2.42.0"
 
+#include <cstdint>
+#include <random>
 #include <string>
 #include <sstream>
 #include <unordered_set>
@@ -55,6 +57,10 @@ enum Skill
 };
 }
 extern const std::string skill_names[Skill::num_skills];
+// The per-skill state of a CardStatus is indexed by skill slot rather than by skill id.
+// Slot 0 stands for any skill the card does not have; its own skills take slots 1..Card::m_num_skill_slots,
+// the skills evolve gives it the next ones. check_skill_slots() checks that every card the battles can field fits.
+const unsigned max_skill_slots = 16;
 
 namespace PassiveBGE {
 enum PassiveBGE
@@ -73,51 +79,35 @@ enum PassiveBGE
 }
 extern const std::string passive_bge_names[PassiveBGE::num_passive_bges];
 
+// Skill classification flags, looked up in skill_classes[] by skill id
+namespace SkillClass {
+enum SkillClass
+{
+    activation_harmful = 1 << 0,
+    activation_hostile = 1 << 1,  // harmful and mimic
+    activation_helpful = 1 << 2,
+    activation_with_x = 1 << 3,
+    defensive = 1 << 4,
+    combat_modifier = 1 << 5,
+    damage_dependent = 1 << 6,
+    triggered = 1 << 7,
+};
+}
+extern const uint8_t skill_classes[Skill::num_skills];
+
 inline bool is_activation_harmful_skill(Skill::Skill skill_id)
 {
-    switch(skill_id)
-    {
-    case Skill::enfeeble:
-    case Skill::jam:
-    case Skill::mortar:
-    case Skill::siege:
-    case Skill::strike:
-    case Skill::sunder:
-    case Skill::weaken:
-        return true;
-    default:
-        return false;
-    }
+    return skill_classes[skill_id] & SkillClass::activation_harmful;
 }
 
 inline bool is_activation_hostile_skill(Skill::Skill skill_id)
 {
-    switch(skill_id)
-    {
-    case Skill::mimic:
-        return true;
-    default:
-        return is_activation_harmful_skill(skill_id);
-    }
+    return skill_classes[skill_id] & SkillClass::activation_hostile;
 }
 
 inline bool is_activation_helpful_skill(Skill::Skill skill_id)
 {
-    switch(skill_id)
-    {
-    case Skill::enhance:
-    case Skill::evolve:
-    case Skill::heal:
-    case Skill::mend:
-    case Skill::overload:
-    case Skill::protect:
-    case Skill::rally:
-    case Skill::enrage:
-    case Skill::rush:
-        return true;
-    default:
-        return false;
-    }
+    return skill_classes[skill_id] & SkillClass::activation_helpful;
 }
 
 inline bool is_activation_allied_skill(Skill::Skill skill_id)
@@ -127,96 +117,32 @@ inline bool is_activation_allied_skill(Skill::Skill skill_id)
 
 inline bool is_activation_skill(Skill::Skill skill_id)
 {
-    return is_activation_hostile_skill(skill_id)
-        || is_activation_allied_skill(skill_id)
-    ;
+    return skill_classes[skill_id] & (SkillClass::activation_hostile | SkillClass::activation_helpful);
 }
 
 inline bool is_activation_skill_with_x(Skill::Skill skill_id)
 {
-    switch(skill_id)
-    {
-    case Skill::enfeeble:
-    case Skill::mortar:
-    case Skill::siege:
-    case Skill::strike:
-    case Skill::sunder:
-    case Skill::weaken:
-    case Skill::enhance:
-    case Skill::mimic:
-    case Skill::heal:
-    case Skill::mend:
-    case Skill::protect:
-    case Skill::rally:
-    case Skill::enrage:
-    case Skill::rush:
-        return true;
-    default:
-        return false;
-    }
+    return skill_classes[skill_id] & SkillClass::activation_with_x;
 }
 
 inline bool is_defensive_skill(Skill::Skill skill_id)
 {
-    switch(skill_id)
-    {
-    case Skill::armor:
-    case Skill::avenge:
-    case Skill::corrosive:
-    case Skill::counter:
-    case Skill::evade:
-    case Skill::payback:
-    case Skill::revenge:
-    case Skill::refresh:
-    case Skill::wall:
-        return true;
-    default:
-        return false;
-    }
+    return skill_classes[skill_id] & SkillClass::defensive;
 }
 
 inline bool is_combat_modifier_skill(Skill::Skill skill_id)
 {
-    switch(skill_id)
-    {
-    case Skill::legion:
-    case Skill::pierce:
-    case Skill::rupture:
-    case Skill::swipe:
-    case Skill::drain:
-    case Skill::venom:
-        return true;
-    default:
-        return false;
-    }
+    return skill_classes[skill_id] & SkillClass::combat_modifier;
 }
 
 inline bool is_damage_dependent_skill(Skill::Skill skill_id)
 {
-    switch(skill_id)
-    {
-    case Skill::berserk:
-    case Skill::inhibit:
-    case Skill::sabotage:
-    case Skill::leech:
-    case Skill::poison:
-        return true;
-    default:
-        return false;
-    }
+    return skill_classes[skill_id] & SkillClass::damage_dependent;
 }
 
 inline bool is_triggered_skill(Skill::Skill skill_id)
 {
-    switch(skill_id)
-    {
-    case Skill::allegiance:
-    case Skill::flurry:
-    case Skill::valor:
-        return true;
-    default:
-        return false;
-    }
+    return skill_classes[skill_id] & SkillClass::triggered;
 }
 
 inline PassiveBGE::PassiveBGE passive_bge_name_to_id(const std::string & name)
@@ -286,7 +212,6 @@ enum gamemode_t
     surge,
 };
 
-#ifndef NQUEST
 namespace QuestType
 {
 enum QuestType
@@ -302,7 +227,6 @@ enum QuestType
     num_objective_types
 };
 }
-#endif
 
 enum class OptimizationMode
 {
@@ -314,9 +238,7 @@ enum class OptimizationMode
     brawl_defense,
     raid,
     campaign,
-#ifndef NQUEST
     quest,
-#endif
     num_optimization_mode
 };
 
@@ -352,6 +274,108 @@ inline uint8_t byte_bits_count(register uint8_t i)
     return (i + (i >> 4)) & 0x0F;
 }
 
+//---------------------- Random number engines ---------------------------------
+// xoshiro128++ by D. Blackman and S. Vigna: 16 bytes of state, much faster than mt19937.
+class Xoshiro128pp
+{
+public:
+    typedef uint32_t result_type;
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return UINT32_MAX; }
+
+    explicit Xoshiro128pp(uint64_t seed_ = 5489u) { seed(seed_); }
+
+    // The state is filled by splitmix64, so that nearby seeds give unrelated streams.
+    void seed(uint64_t seed_)
+    {
+        for (unsigned i = 0; i < 4; i += 2)
+        {
+            uint64_t z = (seed_ += 0x9e3779b97f4a7c15ULL);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            z ^= z >> 31;
+            s[i] = (uint32_t)z;
+            s[i + 1] = (uint32_t)(z >> 32);
+        }
+    }
+
+    inline result_type operator()()
+    {
+        const uint32_t result = rotl(s[0] + s[3], 7) + s[0];
+        const uint32_t t = s[1] << 9;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 11);
+        return result;
+    }
+
+private:
+    static inline uint32_t rotl(const uint32_t x, int k) { return (x << k) | (x >> (32 - k)); }
+    uint32_t s[4];
+};
+
+// Engine of the simulations. Build with -DTUO_MT19937 to reproduce the results (given the seed) of older versions,
+// except for battles with Mimic.
+#ifdef TUO_MT19937
+typedef std::mt19937 RandomEngine;
+#else
+typedef Xoshiro128pp RandomEngine;
+#endif
+
+// splitmix64 finalizer: a bijection of the 64-bit words that spreads nearby inputs apart.
+inline uint64_t mix64(uint64_t z)
+{
+    z += 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// Seed of one random stream of battle #battle_index against enemy deck #deck_index (crn mode).
+// stream: 0 - enemy shuffle; 1 - your shuffle; 2 - in-battle RNG; 3 - whole candidate #battle_index (par-candidates).
+// The battle and the deck are mixed in separately, so no two (battle, deck, stream) of a base seed
+// share a seed (bench/seed_check.cpp). Set it with seed_random_engine().
+inline uint64_t crn_battle_seed(unsigned base_seed, unsigned battle_index, unsigned deck_index, unsigned stream)
+{
+    return mix64(mix64(((uint64_t)base_seed << 32) | battle_index) ^ (((uint64_t)deck_index << 2) | stream));
+}
+
+// Seeds re with all the 64 bits of seed: mt19937::seed(seed) would only keep the low 32 bits.
+inline void seed_random_engine(std::mt19937& re, uint64_t seed)
+{
+    std::seed_seq seed_seq{(uint32_t)seed, (uint32_t)(seed >> 32)};
+    re.seed(seed_seq);
+}
+
+inline void seed_random_engine(Xoshiro128pp& re, uint64_t seed)
+{
+    re.seed(seed);
+}
+
+// Uniform integer in [x, y].
+inline unsigned random_in_range(std::mt19937& re, unsigned x, unsigned y)
+{
+    return std::uniform_int_distribution<unsigned>(x, y)(re);
+}
+
+inline unsigned random_in_range(Xoshiro128pp& re, unsigned x, unsigned y)
+{
+    // Lemire's multiply-shift, with rejection of the biased low products.
+    const uint32_t range = y - x + 1;
+    if (__builtin_expect(range == 0, false)) { return re(); }
+    uint64_t m = (uint64_t)re() * range;
+    if (__builtin_expect((uint32_t)m < range, false))
+    {
+        const uint32_t threshold = -range % range;
+        while ((uint32_t)m < threshold)
+        { m = (uint64_t)re() * range; }
+    }
+    return x + (uint32_t)(m >> 32);
+}
+
 //---------------------- Debugging stuff ---------------------------------------
 extern signed debug_print;
 extern unsigned debug_cached;
@@ -18,8 +18,10 @@
 #include <cstring>
 #include <ctime>
 #include <functional>
+#include <iomanip>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <set>
 #include <stack>
 #include <string>
@@ -29,15 +31,19 @@
 #include <boost/filesystem.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/math/distributions/binomial.hpp>
+#include <boost/math/distributions/normal.hpp>
 #include <boost/optional.hpp>
 #include <boost/range/join.hpp>
 #include <boost/thread/barrier.hpp>
 #include <boost/thread/mutex.hpp>
 #include <boost/thread/thread.hpp>
+#include "alloc_check.h"
 #include "card.h"
 #include "cards.h"
 #include "deck.h"
+#include "lockstep.h"
 #include "read.h"
+#include "result_cache.h"
 #include "sim.h"
 #include "tyrant.h"
 #include "xml.h"
@@ -65,10 +71,16 @@ namespace {
     bool use_harmonic_mean{false};
     unsigned iterations_multiplier{10};
     unsigned sim_seed{0};
+    bool use_crn{false};
+    unsigned crn_min_paired_sims{10};
+    bool use_neyman{false};
+    bool climb_candidates_parallel{false};
+    bool climb_race{false};
+    bool time_thread_waits{false};  // only while threadbench runs
+    std::string result_cache_file;
+    Hash128 card_db_hash;  // of the card files, for the result cache
     Requirement requirement;
-#ifndef NQUEST
     Quest quest;
-#endif
 }
 
 using namespace std::placeholders;
@@ -189,7 +201,7 @@ void append_unless_remove(C & self, C & oppo, typename C::const_reference val)
 
 // insert card at to_slot into deck limited by fund; store deck_cost
 // return true if affordable
-bool adjust_deck(Deck * deck, const signed from_slot, const signed to_slot, const Card * card, unsigned fund, std::mt19937 & re, unsigned & deck_cost,
+bool adjust_deck(Deck * deck, const signed from_slot, const signed to_slot, const Card * card, unsigned fund, RandomEngine & re, unsigned & deck_cost,
         std::vector<std::pair<signed, const Card *>> & cards_out, std::vector<std::pair<signed, const Card *>> & cards_in)
 {
     cards_in.clear();
@@ -293,9 +305,7 @@ bool adjust_deck(Deck * deck, const signed from_slot, const signed to_slot, cons
 }
 
 unsigned check_requirement(const Deck* deck, const Requirement & requirement
-#ifndef NQUEST
     , const Quest & quest
-#endif
 )
 {
     unsigned gap = 0;
@@ -312,7 +322,6 @@ unsigned check_requirement(const Deck* deck, const Requirement & requirement
             gap += safe_minus(it.second, num_cards[it.first]);
         }
     }
-#ifndef NQUEST
     if (quest.quest_type != QuestType::none)
     {
         unsigned potential_value = 0;
@@ -367,7 +376,6 @@ unsigned check_requirement(const Deck* deck, const Requirement & requirement
         }
         gap += safe_minus(quest.must_fulfill ? quest.quest_value : 1, potential_value);
     }
-#endif
     return gap;
 }
 
@@ -390,27 +398,84 @@ void claim_cards(const std::vector<const Card*> & card_list)
     }
 }
 
+//------------------------------------------------------------------------------
+// Battles played against one enemy deck (all of them unless neyman).
+inline int64_t deck_battles(const Results<int64_t>& results)
+{
+    return results.wins + results.draws + results.losses;
+}
+//------------------------------------------------------------------------------
+// Bound of the variance of the points of one battle against one enemy deck: at most
+// mean * (max - mean) (Bhatia-Davis); the mean in the bound gets one win and one loss added,
+// so that a deck that has won nothing yet is not taken as certain.
+long double battle_points_variance(const Results<int64_t>& results)
+{
+    long double max_possible = max_possible_score[(size_t)optimization_mode];
+    long double bound_mean = (results.points + max_possible) / (deck_battles(results) + 2.0L);
+    return bound_mean * (max_possible - bound_mean);
+}
+//------------------------------------------------------------------------------
+// Bound of the variance of the (factor-weighted) mean points over the enemy decks.
+long double points_mean_variance(const std::vector<Results<int64_t>>& results, const std::vector<long double>& factors)
+{
+    long double factor_sum = std::accumulate(factors.begin(), factors.end(), .0);
+    long double variance(0);
+    for (unsigned index(0); index < results.size(); ++index)
+    {
+        long double weight = factors[index] / factor_sum;
+        variance += weight * weight * battle_points_variance(results[index]) / deck_battles(results[index]);
+    }
+    return variance;
+}
+//------------------------------------------------------------------------------
+// neyman: shares of the battles against each enemy deck, in proportion to factor * stddev of its
+// points (Neyman allocation), which minimizes the variance of the mean points for a number of
+// battles. Empty (one battle against each deck) until every deck has been played at least once.
+void neyman_allocation(const std::vector<Results<int64_t>>& results, const std::vector<long double>& factors, std::vector<long double>& shares)
+{
+    shares.clear();
+    for (const auto & deck_results: results)
+    {
+        if (deck_battles(deck_results) == 0)
+        {
+            return;
+        }
+    }
+    long double share_sum(0);
+    for (unsigned index(0); index < results.size(); ++index)
+    {
+        shares.push_back(factors[index] * std::sqrt(battle_points_variance(results[index])));
+        share_sum += shares.back();
+    }
+    for (auto & share: shares)
+    {
+        share /= share_sum;
+    }
+}
 //------------------------------------------------------------------------------
 FinalResults<long double> compute_score(const EvaluatedResults& results, std::vector<long double>& factors)
 {
-    FinalResults<long double> final{0, 0, 0, 0, 0, 0, results.second};
+    FinalResults<long double> final{0, 0, 0, 0, 0, 0, 0, results.second};
     long double max_possible = max_possible_score[(size_t)optimization_mode];
     for (unsigned index(0); index < results.first.size(); ++index)
     {
-        final.wins += results.first[index].wins * factors[index];
-        final.draws += results.first[index].draws * factors[index];
-        final.losses += results.first[index].losses * factors[index];
-        auto lower_bound = boost::math::binomial_distribution<>::find_lower_bound_on_p(results.second, results.first[index].points / max_possible, 1 - confidence_level) * max_possible;
-        auto upper_bound = boost::math::binomial_distribution<>::find_upper_bound_on_p(results.second, results.first[index].points / max_possible, 1 - confidence_level) * max_possible;
+        // neyman: the decks were played a different number of times; scale each one to results.second battles
+        int64_t battles = deck_battles(results.first[index]);
+        long double scale = (long double)results.second / battles;
+        final.wins += results.first[index].wins * factors[index] * scale;
+        final.draws += results.first[index].draws * factors[index] * scale;
+        final.losses += results.first[index].losses * factors[index] * scale;
+        auto lower_bound = boost::math::binomial_distribution<>::find_lower_bound_on_p(battles, results.first[index].points / max_possible, 1 - confidence_level) * max_possible;
+        auto upper_bound = boost::math::binomial_distribution<>::find_upper_bound_on_p(battles, results.first[index].points / max_possible, 1 - confidence_level) * max_possible;
         if (use_harmonic_mean)
         {
-            final.points += factors[index] / results.first[index].points;
+            final.points += factors[index] / (results.first[index].points * scale);
             final.points_lower_bound += factors[index] / lower_bound;
             final.points_upper_bound += factors[index] / upper_bound;
         }
         else
         {
-            final.points += results.first[index].points * factors[index];
+            final.points += results.first[index].points * factors[index] * scale;
             final.points_lower_bound += lower_bound * factors[index];
             final.points_upper_bound += upper_bound * factors[index];
         }
@@ -431,42 +496,173 @@ FinalResults<long double> compute_score(const EvaluatedResults& results, std::ve
         final.points_lower_bound /= factor_sum;
         final.points_upper_bound /= factor_sum;
     }
+    final.points_standard_error = std::sqrt(points_mean_variance(results.first, factors));
     return final;
 }
 //------------------------------------------------------------------------------
+// z of the one-sided confidence_level.
+inline long double confidence_z()
+{
+    static const long double z = boost::math::quantile(boost::math::normal(), (double)confidence_level);
+    return z;
+}
+// Battles of the compared deck at the first look of the stop test of a compare; the next looks come at
+// twice as many battles each, as long as it is below the battles of the compare.
+const unsigned first_stop_test_battles{16};
+// Looks of the stop test of a compare of num_iterations battles.
+inline unsigned stop_test_num_looks(unsigned num_iterations)
+{
+    unsigned num_looks(0);
+    for (uint64_t battles(first_stop_test_battles); battles < num_iterations; battles *= 2)
+    {
+        ++ num_looks;
+    }
+    return num_looks;
+}
+// Battles of the compared deck at its next look, after a look at battles (0: none yet).
+inline unsigned next_stop_test_battles(unsigned battles)
+{
+    uint64_t next(first_stop_test_battles);
+    while (next <= battles)
+    {
+        next *= 2;
+    }
+    return std::min<uint64_t>(next, UINT_MAX);
+}
+// Probability that the standardized difference Z of a deck to the best one, in units of its standard
+// error, stays at or below z at all of num_looks looks, for a deck whose expected difference is on
+// the boundary (min_increment_of_score). With twice the battles at each look, Z_{k+1} = (Z_k + E) / sqrt(2)
+// with E standard normal: the density of the paths that did not cross is carried over a grid of Z.
+inline double stop_test_no_crossing(unsigned num_looks, double z)
+{
+    const unsigned num_points(200);
+    const double low(-8), step((z - low) / (num_points - 1));
+    std::vector<double> density(num_points), next_density(num_points);
+    auto normal_pdf = [](double x) { return std::exp(-x * x / 2) / std::sqrt(2 * M_PI); };
+    for (unsigned i(0); i < num_points; ++i)
+    {
+        density[i] = normal_pdf(low + i * step);
+    }
+    for (unsigned look(1); look < num_looks; ++look)
+    {
+        for (unsigned j(0); j < num_points; ++j)
+        {
+            double w(low + j * step), sum(0);
+            for (unsigned i(0); i < num_points; ++i)
+            {
+                sum += (i == 0 || i + 1 == num_points ? .5 : 1.) * density[i] * M_SQRT2 * normal_pdf(M_SQRT2 * w - (low + i * step));
+            }
+            next_density[j] = sum * step;
+        }
+        density.swap(next_density);
+    }
+    double res(0);
+    for (unsigned i(0); i < num_points; ++i)
+    {
+        res += (i == 0 || i + 1 == num_points ? .5 : 1.) * density[i];
+    }
+    return res * step;
+}
+// z of the stop test of a compare of num_iterations battles: a Pocock boundary, the same at each of its
+// stop_test_num_looks() looks, that a deck on the boundary crosses at one look or another with a probability
+// of 1 - confidence_level. Between confidence_z() (one look) and the z of a union bound over the looks.
+// Solved by bisection once per number of looks; only called by the main thread.
+inline long double stop_test_z(unsigned num_iterations)
+{
+    static std::map<unsigned, long double> cached_z;
+    const unsigned num_looks(std::max(1u, stop_test_num_looks(num_iterations)));
+    auto z_it = cached_z.find(num_looks);
+    if (z_it != cached_z.end())
+    {
+        return z_it->second;
+    }
+    const double alpha(1 - (double)confidence_level);
+    double low(boost::math::quantile(boost::math::complement(boost::math::normal(), alpha)));
+    double high(boost::math::quantile(boost::math::complement(boost::math::normal(), alpha / num_looks)));
+    for (unsigned iteration(0); iteration < 30 && num_looks > 1; ++iteration)
+    {
+        double mid((low + high) / 2);
+        (1 - stop_test_no_crossing(num_looks, mid) > alpha ? low : high) = mid;
+    }
+    return cached_z[num_looks] = num_looks > 1 ? high : low;
+}
+//------------------------------------------------------------------------------
+// Candidate deck of the candidate-parallel climb (par-candidates), compared by a single thread.
+struct ClimbCandidate
+{
+    const Card* commander;
+    std::vector<const Card*> cards;
+    DeckFingerprint fingerprint;
+    EvaluatedResults * results;  // entry of evaluated_decks
+    unsigned gap;
+    unsigned deck_cost;
+    std::vector<std::pair<signed, const Card *>> cards_out, cards_in;
+    uint64_t seed;
+    std::vector<long double> * battle_points;  // crn mode: entry of Process::crn_deck_points
+    FinalResults<long double> score;  // race: after the last round
+    unsigned stop_test_battles;  // its battles at the last look of compare_can_stop() (0: none yet), over the rounds of a race
+};
+//------------------------------------------------------------------------------
 volatile unsigned thread_num_iterations{0}; // written by threads
 EvaluatedResults *thread_results{nullptr}; // written by threads
 volatile const FinalResults<long double> *thread_best_results{nullptr};
+long double thread_best_points_se{0}; // standard error of thread_best_results->points
 volatile bool thread_compare{false};
 volatile bool thread_compare_stop{false}; // written by threads
-volatile bool destroy_threads;
+// Common random numbers (crn) mode: battle #i of every deck replays the same seeds.
+unsigned thread_next_battle{0}; // written by threads
+std::vector<long double> *thread_battle_points{nullptr}; // written by threads
+const std::vector<long double> *thread_best_battle_points{nullptr};
+long double thread_paired_sum{0}; // written by threads
+long double thread_paired_sum_sq{0}; // written by threads
+unsigned thread_paired_n{0}; // written by threads
+long double thread_stop_test_z{0}; // stop_test_z() of the compare
+unsigned thread_stop_test_battles{0}; // written by threads
+std::vector<ClimbCandidate> *thread_candidates{nullptr}; // par-candidates mode
+unsigned thread_next_candidate{0}; // written by threads
+// Upper bound of the battles claimed (and merged) by a thread at once.
+const unsigned max_battles_per_claim{64};
+// Same in compare(), where a look of the stop test can come after each merge; also the battles between two updates
+// of the neyman shares in par-candidates mode.
+const unsigned max_battles_per_stop_test{8};
+// Battles of every candidate in the first round of a race.
+const unsigned race_first_battles{16};
 //------------------------------------------------------------------------------
 // Per thread data.
 // seed should be unique for each thread.
 // d1 and d2 are intended to point to read-only process-wide data.
 struct SimulationData
 {
-    std::mt19937 re;
+    RandomEngine re;
+    RandomEngine crn_re;
     const Cards& cards;
     const Decks& decks;
     std::shared_ptr<Deck> your_deck;
     Hand your_hand;
     std::vector<std::shared_ptr<Deck>> enemy_decks;
     std::vector<Hand*> enemy_hands;
+    std::vector<Field*> fields;  // one per enemy deck, reset before each battle
+    std::vector<Field*> crn_fields;  // same on crn_re
+    // neyman mode: share of the battles of an iteration against each enemy deck (empty: one battle against each)
+    std::vector<long double> neyman_shares;
+    std::vector<long double> neyman_credits;  // battles owed to each enemy deck
     std::vector<long double> factors;
     gamemode_t gamemode;
-#ifndef NQUEST
     Quest quest;
-#endif
     std::unordered_map<unsigned, unsigned> bg_effects;
     std::vector<SkillSpec> your_bg_skills, enemy_bg_skills;
+    // time spent by the thread in main_barrier.wait() and in shared_mutex (waiting for it or holding it)
+    std::chrono::steady_clock::duration barrier_time{0};
+    std::chrono::steady_clock::duration mutex_time{0};
+#ifdef TUO_ALLOC_CHECK
+    BattleAllocations allocations;
+#endif
 
     SimulationData(unsigned seed, const Cards& cards_, const Decks& decks_, unsigned num_enemy_decks_, std::vector<long double> factors_, gamemode_t gamemode_,
-#ifndef NQUEST
             Quest & quest_,
-#endif
             std::unordered_map<unsigned, unsigned>& bg_effects_, std::vector<SkillSpec>& your_bg_skills_, std::vector<SkillSpec>& enemy_bg_skills_) :
         re(seed),
+        crn_re(),
         cards(cards_),
         decks(decks_),
         your_deck(),
@@ -474,9 +670,7 @@ struct SimulationData
         enemy_decks(num_enemy_decks_),
         factors(factors_),
         gamemode(gamemode_),
-#ifndef NQUEST
         quest(quest_),
-#endif
         bg_effects(bg_effects_),
         your_bg_skills(your_bg_skills_),
         enemy_bg_skills(enemy_bg_skills_)
@@ -484,38 +678,131 @@ struct SimulationData
         for (size_t i = 0; i < num_enemy_decks_; ++i)
         {
             enemy_hands.emplace_back(new Hand(nullptr));
+            fields.emplace_back(new Field(re, cards, your_hand, *enemy_hands.back(), gamemode, optimization_mode,
+                quest,
+                bg_effects, your_bg_skills, enemy_bg_skills));
+            crn_fields.emplace_back(new Field(crn_re, cards, your_hand, *enemy_hands.back(), gamemode, optimization_mode,
+                quest,
+                bg_effects, your_bg_skills, enemy_bg_skills));
         }
     }
 
     ~SimulationData()
     {
+        for(auto field: fields) { delete(field); }
+        for(auto field: crn_fields) { delete(field); }
         for(auto hand: enemy_hands) { delete(hand); }
     }
 
+#ifdef TUO_PROFILE
+    void add_profile(BattleProfile& total) const
+    {
+        for(auto field: fields) { total += field->profile; }
+        for(auto field: crn_fields) { total += field->profile; }
+    }
+#endif
+
+    // Only the commander and the cards of the attack deck change between two calls.
+    // The neyman credits owed to the previous attack deck are dropped.
+    void set_your_cards(const Card* commander, const std::vector<const Card*>& cards_)
+    {
+        your_deck->commander = commander;
+        your_deck->cards = cards_;
+        neyman_credits.clear();
+    }
+
+    // neyman mode: recompute the shares from the results so far. The credits carry over to the
+    // new shares, kept to the fraction of a battle in [0, 1) each deck is owed.
+    void update_neyman_shares(const std::vector<Results<int64_t>>& results)
+    {
+        neyman_allocation(results, factors, neyman_shares);
+        for (auto & credit: neyman_credits)
+        {
+            credit = std::max<long double>(0, credit - std::floor(credit));
+        }
+    }
+
+    // The decks are cloned on the first call only: the enemy decks don't change during a run
+    // and the attack deck just gets its commander, cards and strategy updated.
     void set_decks(const Deck* const your_deck_, std::vector<Deck*> const & enemy_decks_)
     {
-        your_deck.reset(your_deck_->clone());
-        your_hand.deck = your_deck.get();
+        if(!your_deck)
+        {
+            your_deck.reset(your_deck_->clone());
+            your_hand.deck = your_deck.get();
+        }
+        else
+        {
+            set_your_cards(your_deck_->commander, your_deck_->cards);
+            your_deck->strategy = your_deck_->strategy;
+        }
         for(unsigned i(0); i < enemy_decks_.size(); ++i)
         {
-            enemy_decks[i].reset(enemy_decks_[i]->clone());
-            enemy_hands[i]->deck = enemy_decks[i].get();
+            if(!enemy_decks[i])
+            {
+                enemy_decks[i].reset(enemy_decks_[i]->clone());
+                enemy_hands[i]->deck = enemy_decks[i].get();
+            }
         }
     }
 
     inline std::vector<Results<uint64_t>> evaluate()
     {
+        if (!neyman_shares.empty())
+        {
+            return(evaluate_neyman());
+        }
         std::vector<Results<uint64_t>> res;
-        for(Hand* enemy_hand: enemy_hands)
+        res.reserve(enemy_hands.size());
+        for(unsigned i(0); i < enemy_hands.size(); ++i)
         {
+            TUO_ALLOC_CHECK_BATTLE(allocations);
             your_hand.reset(re);
-            enemy_hand->reset(re);
-            Field fd(re, cards, your_hand, *enemy_hand, gamemode, optimization_mode,
-#ifndef NQUEST
-                quest,
-#endif
-                bg_effects, your_bg_skills, enemy_bg_skills);
-            Results<uint64_t> result(play(&fd));
+            enemy_hands[i]->reset(re);
+            fields[i]->reset();
+            Results<uint64_t> result(play(fields[i]));
+            res.emplace_back(result);
+        }
+        return(res);
+    }
+
+    // As many battles as enemy decks, spread over them by neyman_shares; the fractions of a battle
+    // owed to a deck carry over to the next iterations.
+    std::vector<Results<uint64_t>> evaluate_neyman()
+    {
+        const unsigned num_decks(enemy_hands.size());
+        std::vector<Results<uint64_t>> res(num_decks);
+        neyman_credits.resize(num_decks, 0);
+        for(unsigned i(0); i < num_decks; ++i)
+        {
+            neyman_credits[i] += neyman_shares[i] * num_decks;
+            for(; neyman_credits[i] >= 1; neyman_credits[i] -= 1)
+            {
+                TUO_ALLOC_CHECK_BATTLE(allocations);
+                your_hand.reset(re);
+                enemy_hands[i]->reset(re);
+                fields[i]->reset();
+                res[i] += play(fields[i]);
+            }
+        }
+        return(res);
+    }
+
+    // Replays the seeds of battle #battle_index so that every attack deck faces the same draws.
+    inline std::vector<Results<uint64_t>> evaluate_crn(unsigned crn_seed, unsigned battle_index)
+    {
+        std::vector<Results<uint64_t>> res;
+        res.reserve(enemy_hands.size());
+        for(unsigned i(0); i < enemy_hands.size(); ++i)
+        {
+            TUO_ALLOC_CHECK_BATTLE(allocations);
+            seed_random_engine(crn_re, crn_battle_seed(crn_seed, battle_index, i, 0));
+            enemy_hands[i]->reset(crn_re);
+            seed_random_engine(crn_re, crn_battle_seed(crn_seed, battle_index, i, 1));
+            your_hand.reset(crn_re);
+            seed_random_engine(crn_re, crn_battle_seed(crn_seed, battle_index, i, 2));
+            crn_fields[i]->reset();
+            Results<uint64_t> result(play(crn_fields[i]));
             res.emplace_back(result);
         }
         return(res);
@@ -543,16 +830,22 @@ public:
     const std::vector<Deck*> enemy_decks;
     std::vector<long double> factors;
     gamemode_t gamemode;
-#ifndef NQUEST
     Quest quest;
-#endif
     std::unordered_map<unsigned, unsigned> bg_effects;
     std::vector<SkillSpec> your_bg_skills, enemy_bg_skills;
+    unsigned crn_seed;  // the RNG seed: base of the crn seeds and of Climb::re
+    // crn mode: per-battle points (NaN: unknown) of the incumbent and of the decks being compared, by their
+    // results, so that a deck keeps them until it is accepted or rejected. A deck compared again after
+    // it was rejected pairs its new battles only.
+    std::unordered_map<const EvaluatedResults*, std::vector<long double>> crn_deck_points;
+    const EvaluatedResults * crn_best_results{nullptr};  // the incumbent
+    unsigned num_compared_candidates{0};
+    unsigned num_compares{0};
+    unsigned num_compares_stopped{0};  // by compare_can_stop() before all the iterations were played
+    volatile bool destroy_threads{false};
 
     Process(unsigned num_threads_, const Cards& cards_, const Decks& decks_, Deck* your_deck_, std::vector<Deck*> enemy_decks_, std::vector<long double> factors_, gamemode_t gamemode_,
-#ifndef NQUEST
             Quest & quest_,
-#endif
             std::unordered_map<unsigned, unsigned>& bg_effects_, std::vector<SkillSpec>& your_bg_skills_, std::vector<SkillSpec>& enemy_bg_skills_) :
         num_threads(num_threads_),
         main_barrier(num_threads+1),
@@ -562,25 +855,21 @@ public:
         enemy_decks(enemy_decks_),
         factors(factors_),
         gamemode(gamemode_),
-#ifndef NQUEST
         quest(quest_),
-#endif
         bg_effects(bg_effects_),
         your_bg_skills(your_bg_skills_),
         enemy_bg_skills(enemy_bg_skills_)
     {
-        destroy_threads = false;
         unsigned seed(sim_seed ? sim_seed : std::chrono::system_clock::now().time_since_epoch().count() * 2654435761);  // Knuth multiplicative hash
         if (num_threads_ == 1)
         {
             std::cout << "RNG seed " << seed << std::endl;
         }
+        crn_seed = seed;
         for(unsigned i(0); i < num_threads; ++i)
         {
             threads_data.push_back(new SimulationData(seed + i, cards, decks, enemy_decks.size(), factors, gamemode,
-#ifndef NQUEST
                 quest,
-#endif
                 bg_effects, your_bg_skills, enemy_bg_skills));
             threads.push_back(new boost::thread(thread_evaluate, std::ref(main_barrier), std::ref(shared_mutex), std::ref(*threads_data.back()), std::ref(*this), i));
         }
@@ -591,6 +880,16 @@ public:
         destroy_threads = true;
         main_barrier.wait();
         for(auto thread: threads) { thread->join(); }
+#ifdef TUO_PROFILE
+        BattleProfile profile;
+        for(auto data: threads_data) { data->add_profile(profile); }
+        profile.print(std::cout);
+#endif
+#ifdef TUO_ALLOC_CHECK
+        BattleAllocations allocations;
+        for(auto data: threads_data) { allocations += data->allocations; }
+        allocations.print(std::cout);
+#endif
         for(auto data: threads_data) { delete(data); }
     }
 
@@ -603,6 +902,11 @@ public:
         thread_num_iterations = num_iterations - evaluated_results.second;
         thread_results = &evaluated_results;
         thread_compare = false;
+        thread_next_battle = evaluated_results.second;
+        // the evaluated deck is the incumbent
+        crn_best_results = &evaluated_results;
+        thread_battle_points = crn_points(&evaluated_results);
+        thread_best_battle_points = nullptr;
         // unlock all the threads
         main_barrier.wait();
         // wait for the threads
@@ -619,16 +923,306 @@ public:
         thread_num_iterations = num_iterations - evaluated_results.second;
         thread_results = &evaluated_results;
         thread_best_results = &best_results;
+        thread_best_points_se = best_results.points_standard_error;
         thread_compare = true;
         thread_compare_stop = false;
+        thread_next_battle = evaluated_results.second;
+        thread_battle_points = crn_points(&evaluated_results);
+        thread_best_battle_points = crn_points(crn_best_results);
+        thread_paired_sum = 0;
+        thread_paired_sum_sq = 0;
+        thread_paired_n = 0;
+        thread_stop_test_z = stop_test_z(num_iterations);
+        thread_stop_test_battles = 0;
         // unlock all the threads
         main_barrier.wait();
         // wait for the threads
         main_barrier.wait();
+        ++ num_compares;
+        if (thread_compare_stop)
+        {
+            ++ num_compares_stopped;
+        }
         return evaluated_results;
     }
+
+    // Every thread compares whole candidates (one at a time) against best_results.
+    // Returns the best improvement (lowest gap, then highest score, then first one) or nullptr.
+    ClimbCandidate * compare_candidates(unsigned num_iterations, std::vector<ClimbCandidate> & candidates, const FinalResults<long double> & best_results, unsigned best_gap)
+    {
+        thread_stop_test_z = stop_test_z(num_iterations);
+        play_candidates(num_iterations, candidates, best_results);
+        return best_improvement(candidates, best_results, best_gap);
+    }
+
+    // Successive halving over the candidates of a slot (race). The candidates left play up to
+    // race_first_battles battles, then twice as many, and so on up to num_iterations. Each round drops
+    // the candidates whose compare stopped early, then the worse half of the others. Ends early when
+    // the leader beats best_results by min_increment_of_score with confidence_level: the leader alone
+    // then plays up to num_iterations battles, so that the winner is measured as precisely as the best
+    // deck it replaces (its battles are the size of the next compares).
+    // Returns the winner or nullptr, like compare_candidates().
+    ClimbCandidate * race_candidates(unsigned num_iterations, std::vector<ClimbCandidate> & candidates, const FinalResults<long double> & best_results, unsigned best_gap)
+    {
+        // the looks of the stop test of a candidate go on over the rounds
+        thread_stop_test_z = stop_test_z(num_iterations);
+        for(unsigned round_iterations(std::min(race_first_battles, num_iterations)); ; round_iterations = std::min(2 * round_iterations, num_iterations))
+        {
+            play_candidates(round_iterations, candidates, best_results);
+            if (round_iterations == num_iterations)
+            {
+                return best_improvement(candidates, best_results, best_gap);
+            }
+            candidates.erase(std::remove_if(candidates.begin(), candidates.end(),
+                [round_iterations](const ClimbCandidate & candidate) { return candidate.results->second < round_iterations; }), candidates.end());
+            if (candidates.empty())
+            {
+                return nullptr;
+            }
+            for(auto & candidate: candidates)
+            {
+                candidate.score = compute_score(*candidate.results, factors);
+            }
+            std::stable_sort(candidates.begin(), candidates.end(), [](const ClimbCandidate & a, const ClimbCandidate & b)
+                { return a.gap < b.gap || (a.gap == b.gap && a.score.points > b.score.points); });
+            const FinalResults<long double> & leader_score = candidates.front().score;
+            long double standard_error = std::sqrt(leader_score.points_standard_error * leader_score.points_standard_error
+                + best_results.points_standard_error * best_results.points_standard_error);
+            if (leader_score.points - confidence_z() * standard_error > best_results.points + min_increment_of_score)
+            {
+                candidates.erase(candidates.begin() + 1, candidates.end());
+                play_candidates(num_iterations, candidates, best_results);
+                return best_improvement(candidates, best_results, best_gap);
+            }
+            candidates.erase(candidates.begin() + (candidates.size() + 1) / 2, candidates.end());
+        }
+    }
+
+    // Plays the candidates up to num_iterations battles on all the threads (compare_candidates, race_candidates).
+    void play_candidates(unsigned num_iterations, std::vector<ClimbCandidate> & candidates, const FinalResults<long double> & best_results)
+    {
+        for(auto & candidate: candidates)
+        {
+            // Seeded by candidate so that the results don't depend on the thread that compares it.
+            candidate.seed = crn_battle_seed(crn_seed, num_compared_candidates ++, 0, 3);
+            candidate.battle_points = crn_points(candidate.results);
+        }
+        thread_num_iterations = num_iterations;
+        thread_best_results = &best_results;
+        thread_best_points_se = best_results.points_standard_error;
+        thread_best_battle_points = crn_points(crn_best_results);
+        thread_candidates = &candidates;
+        thread_next_candidate = 0;
+        // unlock all the threads
+        main_barrier.wait();
+        // wait for the threads
+        main_barrier.wait();
+        thread_candidates = nullptr;
+    }
+
+    // The best improvement over best_results among the played candidates.
+    ClimbCandidate * best_improvement(std::vector<ClimbCandidate> & candidates, const FinalResults<long double> & best_results, unsigned best_gap)
+    {
+        ClimbCandidate * best_candidate = nullptr;
+        long double best_candidate_points = 0;
+        for(auto & candidate: candidates)
+        {
+            auto score = compute_score(*candidate.results, factors);
+            if (candidate.gap >= best_gap && score.points <= best_results.points + min_increment_of_score)
+            { continue; }
+            if (best_candidate == nullptr || candidate.gap < best_candidate->gap || (candidate.gap == best_candidate->gap && score.points > best_candidate_points))
+            {
+                best_candidate = &candidate;
+                best_candidate_points = score.points;
+            }
+        }
+        return best_candidate;
+    }
+
+    // Sum over the threads of SimulationData::barrier_time and mutex_time. Only while the threads wait (time_thread_waits).
+    std::chrono::steady_clock::duration barrier_time() const
+    {
+        std::chrono::steady_clock::duration res{0};
+        for(auto data: threads_data) { res += data->barrier_time; }
+        return res;
+    }
+
+    std::chrono::steady_clock::duration mutex_time() const
+    {
+        std::chrono::steady_clock::duration res{0};
+        for(auto data: threads_data) { res += data->mutex_time; }
+        return res;
+    }
+
+    void reset_thread_times()
+    {
+        for(auto data: threads_data)
+        {
+            data->barrier_time = std::chrono::steady_clock::duration{0};
+            data->mutex_time = std::chrono::steady_clock::duration{0};
+        }
+    }
+
+    // The deck of results becomes the incumbent of the paired test.
+    void accept_candidate(const EvaluatedResults & results)
+    {
+        if (crn_best_results && crn_best_results != &results)
+        {
+            crn_deck_points.erase(crn_best_results);
+        }
+        crn_best_results = &results;
+    }
+
+    // The deck of results lost its compare: its per-battle points are no longer needed.
+    void reject_candidate(const EvaluatedResults & results)
+    {
+        if (&results != crn_best_results)
+        {
+            crn_deck_points.erase(&results);
+        }
+    }
+
+    // crn mode: the per-battle points of the deck of results (null without crn).
+    std::vector<long double> * crn_points(const EvaluatedResults * results)
+    {
+        return use_crn && results ? &crn_deck_points[results] : nullptr;
+    }
+
+    // A new climb: the results of the previous one are gone.
+    void clear_crn_points()
+    {
+        crn_deck_points.clear();
+        crn_best_results = nullptr;
+    }
 };
 //------------------------------------------------------------------------------
+// Racing test of a compare, on the merged results of the compared deck: whether it can no longer beat
+// the best one by min_increment_of_score. The difference of their points is taken as normally
+// distributed. The test only looks at the results when the compared deck reaches the battles of its next
+// look (next_stop_test_battles()), and stops when the difference stays below min_increment_of_score by
+// z standard errors, z being stop_test_z() of the compare: all the looks of the compare together stop
+// a deck that could beat the best one with a probability of about 1 - confidence_level. Closed form, so
+// that it can run after every batch of battles. last_look: the battles at the last look, updated here.
+bool compare_can_stop(const std::vector<long double>& factors, const std::vector<Results<int64_t>>& results, unsigned total,
+        long double paired_sum, long double paired_sum_sq, unsigned paired_n, long double best_points, long double best_points_se,
+        long double z, unsigned & last_look)
+{
+    if(total < next_stop_test_battles(last_look))
+    {
+        return(false);
+    }
+    last_look = total;
+    if(paired_n >= crn_min_paired_sims)
+    {
+        // Paired test on the differences to the incumbent over identical battles.
+        long double mean_diff = paired_sum / paired_n;
+        long double var_diff = std::max<long double>(0, (paired_sum_sq - paired_n * mean_diff * mean_diff) / (paired_n - 1));
+        return(mean_diff + z * std::sqrt(var_diff / paired_n) < min_increment_of_score);
+    }
+    // Unpaired test, also accounting for the uncertainty of the best deck.
+    long double factor_sum = std::accumulate(factors.begin(), factors.end(), .0);
+    long double mean(0);
+    for(unsigned index(0); index < results.size(); ++index)
+    {
+        mean += factors[index] / factor_sum * results[index].points / deck_battles(results[index]);
+    }
+    long double standard_error = std::sqrt(points_mean_variance(results, factors) + best_points_se * best_points_se);
+    return(mean - best_points + z * standard_error < min_increment_of_score);
+}
+//------------------------------------------------------------------------------
+// main_barrier.wait(), shared_mutex.lock() and shared_mutex.unlock() of a thread, timed in sim
+// if time_thread_waits.
+inline void wait_main_barrier(boost::barrier& main_barrier, SimulationData& sim)
+{
+    if (!time_thread_waits)
+    {
+        main_barrier.wait();
+        return;
+    }
+    auto start = std::chrono::steady_clock::now();
+    main_barrier.wait();
+    sim.barrier_time += std::chrono::steady_clock::now() - start;
+}
+inline std::chrono::steady_clock::time_point lock_shared_mutex(boost::mutex& shared_mutex)
+{
+    std::chrono::steady_clock::time_point start;
+    if (time_thread_waits)
+    {
+        start = std::chrono::steady_clock::now();
+    }
+    shared_mutex.lock();
+    return start;
+}
+inline void unlock_shared_mutex(boost::mutex& shared_mutex, SimulationData& sim, std::chrono::steady_clock::time_point lock_start)
+{
+    shared_mutex.unlock();
+    if (time_thread_waits)
+    {
+        sim.mutex_time += std::chrono::steady_clock::now() - lock_start;
+    }
+}
+//------------------------------------------------------------------------------
+// par-candidates: take candidates until none is left and compare each one on this thread only.
+void thread_compare_candidates(boost::mutex& shared_mutex, SimulationData& sim, const Process& p)
+{
+    const unsigned num_results(sim.enemy_hands.size());
+    const unsigned num_iterations{thread_num_iterations};
+    while(true)
+    {
+        auto lock_start = lock_shared_mutex(shared_mutex); //<<<<
+        unsigned candidate_index = thread_next_candidate++; //!
+        unlock_shared_mutex(shared_mutex, sim, lock_start); //>>>>
+        if(candidate_index >= thread_candidates->size())
+        { return; }
+        ClimbCandidate & candidate = (*thread_candidates)[candidate_index];
+        EvaluatedResults & results = *candidate.results;
+        if(num_iterations <= results.second)
+        { continue; }
+        sim.set_your_cards(candidate.commander, candidate.cards);
+        seed_random_engine(sim.re, candidate.seed);
+        long double paired_sum{0}, paired_sum_sq{0};
+        unsigned paired_n{0};
+        const unsigned first_battle(results.second);
+        for(unsigned battle_index(first_battle); battle_index < num_iterations; ++battle_index)
+        {
+            if(use_neyman && !use_crn && (battle_index == first_battle || battle_index % max_battles_per_stop_test == 0))
+            {
+                sim.update_neyman_shares(results.first);
+            }
+            std::vector<Results<uint64_t>> result{use_crn ? sim.evaluate_crn(p.crn_seed, battle_index) : sim.evaluate()};
+            for(unsigned index(0); index < num_results; ++index)
+            {
+                results.first[index] += result[index];
+            }
+            ++results.second;
+            if(use_crn)
+            {
+                long double battle_points = 0;
+                for(unsigned index(0); index < num_results; ++index)
+                {
+                    battle_points += result[index].points * sim.factors[index];
+                }
+                battle_points /= std::accumulate(sim.factors.begin(), sim.factors.end(), .0);
+                if(candidate.battle_points->size() <= battle_index)
+                {
+                    candidate.battle_points->resize(battle_index + 1, std::numeric_limits<long double>::quiet_NaN());
+                }
+                (*candidate.battle_points)[battle_index] = battle_points;
+                if(thread_best_battle_points && battle_index < thread_best_battle_points->size() && !std::isnan((*thread_best_battle_points)[battle_index]))
+                {
+                    long double diff = battle_points - (*thread_best_battle_points)[battle_index];
+                    paired_sum += diff;
+                    paired_sum_sq += diff * diff;
+                    ++paired_n;
+                }
+            }
+            if(compare_can_stop(sim.factors, results.first, results.second, paired_sum, paired_sum_sq, paired_n, thread_best_results->points, thread_best_points_se,
+                    thread_stop_test_z, candidate.stop_test_battles))
+            { break; }
+        }
+    }
+}
+//------------------------------------------------------------------------------
 void thread_evaluate(boost::barrier& main_barrier,
                      boost::mutex& shared_mutex,
                      SimulationData& sim,
@@ -637,66 +1231,97 @@ void thread_evaluate(boost::barrier& main_barrier,
 {
     while(true)
     {
-        main_barrier.wait();
+        wait_main_barrier(main_barrier, sim);
         sim.set_decks(p.your_deck, p.enemy_decks);
-        if(destroy_threads)
+        if(p.destroy_threads)
         { return; }
+        if(thread_candidates)
+        {
+            thread_compare_candidates(shared_mutex, sim, p);
+            wait_main_barrier(main_barrier, sim);
+            continue;
+        }
+        const unsigned num_results(sim.enemy_hands.size());
         while(true)
         {
-            shared_mutex.lock(); //<<<<
+            // Claim a chunk of battles; chunks shrink towards the end so that the threads finish together.
+            auto lock_start = lock_shared_mutex(shared_mutex); //<<<<
             if(thread_num_iterations == 0 || (thread_compare && thread_compare_stop)) //!
             {
-                shared_mutex.unlock(); //>>>>
-                main_barrier.wait();
+                unlock_shared_mutex(shared_mutex, sim, lock_start); //>>>>
+                wait_main_barrier(main_barrier, sim);
                 break;
             }
-            else
+            unsigned remaining_iterations{thread_num_iterations}; //!
+            unsigned max_battles = thread_compare ? max_battles_per_stop_test : max_battles_per_claim;
+            unsigned num_battles = std::min(remaining_iterations, std::max(1u, std::min(max_battles, remaining_iterations / (4 * p.num_threads))));
+            thread_num_iterations -= num_battles; //!
+            unsigned first_battle = thread_next_battle; //!
+            thread_next_battle += num_battles; //!
+            if(use_neyman && !use_crn)
+            {
+                sim.update_neyman_shares(thread_results->first); //!
+            }
+            unlock_shared_mutex(shared_mutex, sim, lock_start); //>>>>
+            std::vector<Results<uint64_t>> local_results(num_results);
+            unsigned local_total{0};
+            std::vector<std::pair<unsigned, long double>> local_battle_points;
+            long double local_paired_sum{0}, local_paired_sum_sq{0};
+            unsigned local_paired_n{0};
+            // A stopped compare leaves the rest of the chunk, except in crn mode: the battles played have to be
+            // #0 to #results.second - 1, where a later evaluation of the deck goes on from.
+            for(unsigned battle_index(first_battle); battle_index < first_battle + num_battles && !(thread_compare && thread_compare_stop && !use_crn); ++battle_index)
             {
-                --thread_num_iterations; //!
-                shared_mutex.unlock(); //>>>>
-                std::vector<Results<uint64_t>> result{sim.evaluate()};
-                shared_mutex.lock(); //<<<<
-                std::vector<uint64_t> thread_score_local(thread_results->first.size(), 0u); //!
-                for(unsigned index(0); index < result.size(); ++index)
+                std::vector<Results<uint64_t>> result{use_crn ? sim.evaluate_crn(p.crn_seed, battle_index) : sim.evaluate()};
+                for(unsigned index(0); index < num_results; ++index)
                 {
-                    thread_results->first[index] += result[index]; //!
-                    thread_score_local[index] = thread_results->first[index].points; //!
+                    local_results[index] += result[index];
                 }
-                ++thread_results->second; //!
-                unsigned thread_total_local{thread_results->second}; //!
-                shared_mutex.unlock(); //>>>>
-                if(thread_compare && thread_id == 0 && thread_total_local > 1)
+                ++local_total;
+                if(use_crn)
                 {
-                    unsigned score_accum = 0;
-                    // Multiple defense decks case: scaling by factors and approximation of a "discrete" number of events.
-                    if(result.size() > 1)
-                    {
-                        long double score_accum_d = 0.0;
-                        for(unsigned i = 0; i < thread_score_local.size(); ++i)
-                        {
-                            score_accum_d += thread_score_local[i] * sim.factors[i];
-                        }
-                        score_accum_d /= std::accumulate(sim.factors.begin(), sim.factors.end(), .0);
-                        score_accum = score_accum_d;
-                    }
-                    else
+                    long double battle_points = 0;
+                    for(unsigned index(0); index < num_results; ++index)
                     {
-                        score_accum = thread_score_local[0];
+                        battle_points += result[index].points * sim.factors[index];
                     }
-                    bool compare_stop(false);
-                    long double max_possible = max_possible_score[(size_t)optimization_mode];
-                    // Get a loose (better than no) upper bound. TODO: Improve it.
-                    compare_stop = (boost::math::binomial_distribution<>::find_upper_bound_on_p(thread_total_local, score_accum / max_possible, 1 - confidence_level) * max_possible <
-                            thread_best_results->points + min_increment_of_score);
-                    if(compare_stop)
+                    battle_points /= std::accumulate(sim.factors.begin(), sim.factors.end(), .0);
+                    local_battle_points.emplace_back(battle_index, battle_points);
+                    // thread_best_battle_points is not modified while the threads run.
+                    if(thread_best_battle_points && battle_index < thread_best_battle_points->size() && !std::isnan((*thread_best_battle_points)[battle_index]))
                     {
-                        shared_mutex.lock(); //<<<<
-                        //std::cout << thread_total_local << "\n";
-                        thread_compare_stop = true; //!
-                        shared_mutex.unlock(); //>>>>
+                        long double diff = battle_points - (*thread_best_battle_points)[battle_index];
+                        local_paired_sum += diff;
+                        local_paired_sum_sq += diff * diff;
+                        ++local_paired_n;
                     }
                 }
             }
+            // Merge the chunk, then test the merged results of all the threads.
+            lock_start = lock_shared_mutex(shared_mutex); //<<<<
+            for(unsigned index(0); index < num_results; ++index)
+            {
+                thread_results->first[index] += local_results[index]; //!
+            }
+            thread_results->second += local_total; //!
+            for(const auto & battle_points: local_battle_points)
+            {
+                if(thread_battle_points->size() <= battle_points.first) //!
+                {
+                    thread_battle_points->resize(battle_points.first + 1, std::numeric_limits<long double>::quiet_NaN()); //!
+                }
+                (*thread_battle_points)[battle_points.first] = battle_points.second; //!
+            }
+            thread_paired_sum += local_paired_sum; //!
+            thread_paired_sum_sq += local_paired_sum_sq; //!
+            thread_paired_n += local_paired_n; //!
+            if(thread_compare && !thread_compare_stop && //!
+                compare_can_stop(sim.factors, thread_results->first, thread_results->second, thread_paired_sum, thread_paired_sum_sq, thread_paired_n, //!
+                    thread_best_results->points, thread_best_points_se, thread_stop_test_z, thread_stop_test_battles)) //!
+            {
+                thread_compare_stop = true; //!
+            }
+            unlock_shared_mutex(shared_mutex, sim, lock_start); //>>>>
         }
     }
 }
@@ -718,11 +1343,9 @@ void print_score_info(const EvaluatedResults& results, std::vector<long double>&
             case OptimizationMode::brawl:
             case OptimizationMode::brawl_defense:
             case OptimizationMode::war:
-#ifndef NQUEST
             case OptimizationMode::quest:
                 std::cout << val.points << " ";
                 break;
-#endif
             default:
                 std::cout << val.points / 100 << " ";
                 break;
@@ -755,14 +1378,22 @@ void print_results(const EvaluatedResults& results, std::vector<long double>& fa
     }
     std::cout << "/ " << results.second << ")" << std::endl;
 
-#ifndef NQUEST
+    if (use_neyman)
+    {
+        std::cout << "battles: (";
+        for (const auto & val : results.first)
+        {
+            std::cout << deck_battles(val) << " ";
+        }
+        std::cout << "/ " << results.second << ")" << std::endl;
+    }
+
     if (optimization_mode == OptimizationMode::quest)
     {
         // points = win% * win_score + (must_win ? win% : 100%) * quest% * quest_score
         // quest% = (points - win% * win_score) / (must_win ? win% : 100%) / quest_score
         std::cout << "quest%: " << (final.points - final.wins * quest.win_score) / (quest.must_win ? final.wins : 1) / quest.quest_score * 100 << std::endl;
     }
-#endif
 
     unsigned min_score = min_possible_score[(size_t)optimization_mode];
     unsigned max_score = max_possible_score[(size_t)optimization_mode];
@@ -773,9 +1404,7 @@ void print_results(const EvaluatedResults& results, std::vector<long double>& fa
         case OptimizationMode::brawl:
         case OptimizationMode::brawl_defense:
         case OptimizationMode::war:
-#ifndef NQUEST
         case OptimizationMode::quest:
-#endif
             std::cout << "score: " << final.points;
             if (optimization_mode == OptimizationMode::brawl)
             {
@@ -822,16 +1451,12 @@ void print_deck_inline(const unsigned deck_cost, const FinalResults<long double>
         case OptimizationMode::brawl:
         case OptimizationMode::brawl_defense:
         case OptimizationMode::war:
-#ifndef NQUEST
         case OptimizationMode::quest:
-#endif
             std::cout << "(" << score.wins * 100 << "% win";
-#ifndef NQUEST
             if (optimization_mode == OptimizationMode::quest)
             {
                 std::cout << ", " << (score.points - score.wins * quest.win_score) / (quest.must_win ? score.wins : 1) / quest.quest_score * 100 << "% quest";
             }
-#endif
             if (show_ci)
             {
                 std::cout << ", " << score.points_lower_bound << "-" << score.points_upper_bound;
@@ -898,114 +1523,333 @@ void print_deck_inline(const unsigned deck_cost, const FinalResults<long double>
     std::cout << std::endl;
 }
 //------------------------------------------------------------------------------
+// cache <file>: the results cached for the climbs of d1 against the enemy decks of proc (null: no cache).
+// Their context is everything but d1 that the battles depend on; the factors are not part of it,
+// since the results are kept per enemy deck.
+ResultCache* open_result_cache(const Process& proc, const Deck* d1)
+{
+    if (result_cache_file.empty())
+    {
+        return nullptr;
+    }
+    Hash128 context;
+    context.add(card_db_hash.low);
+    context.add(card_db_hash.high);
+    context.add(gamemode);
+    context.add((unsigned)optimization_mode);
+    context.add(turn_limit);
+    std::vector<const Deck*> decks{d1};
+    decks.insert(decks.end(), proc.enemy_decks.begin(), proc.enemy_decks.end());
+    for (const Deck* deck: decks)
+    {
+        if (deck != d1)
+        {
+            context.add(deck->long_description());
+        }
+        context.add(deck->strategy);
+        context.add(deck->upgrade_points);
+        context.add(deck->upgrade_opportunities);
+        for (const Card* card: deck->fortress_cards)
+        {
+            context.add(card->m_id);
+        }
+        for (unsigned id: std::set<unsigned>(deck->vip_cards.begin(), deck->vip_cards.end()))
+        {
+            context.add(id);
+        }
+        for (unsigned id: deck->given_hand)
+        {
+            context.add(id);
+        }
+    }
+    std::map<unsigned, unsigned> bg_effects(proc.bg_effects.begin(), proc.bg_effects.end());
+    for (const auto & bg_effect: bg_effects)
+    {
+        context.add(bg_effect.first);
+        context.add(bg_effect.second);
+    }
+    for (const auto * bg_skills: {&proc.your_bg_skills, &proc.enemy_bg_skills})
+    {
+        context.add(bg_skills->size());
+        for (const auto & s: *bg_skills)
+        {
+            for (unsigned value: {(unsigned)s.id, s.x, (unsigned)s.y, s.n, s.c, (unsigned)s.s, (unsigned)s.s2, (unsigned)s.all})
+            {
+                context.add(value);
+            }
+        }
+    }
+    for (unsigned value: {(unsigned)proc.quest.quest_type, proc.quest.quest_key, proc.quest.quest_2nd_key, proc.quest.quest_value,
+            proc.quest.quest_score, proc.quest.win_score, (unsigned)proc.quest.must_fulfill, (unsigned)proc.quest.must_win})
+    {
+        context.add(value);
+    }
+    try
+    {
+        return new ResultCache(result_cache_file, context, proc.enemy_decks.size());
+    }
+    catch (const std::runtime_error& e)
+    {
+        std::cerr << "Warning: result cache " << result_cache_file << ": " << e.what() << "; not used." << std::endl;
+        return nullptr;
+    }
+}
+//------------------------------------------------------------------------------
+// cache <file>: add the battles of the climb since the last call to the cache; returns the number of decks.
+unsigned save_result_cache(ResultCache* result_cache, const EvaluatedDecks& evaluated_decks)
+{
+    if (!result_cache)
+    {
+        return 0;
+    }
+    try
+    {
+        return result_cache->append(evaluated_decks);
+    }
+    catch (const std::runtime_error& e)
+    {
+        std::cerr << "Warning: result cache " << result_cache_file << ": " << e.what() << std::endl;
+        return 0;
+    }
+}
+//------------------------------------------------------------------------------
+// What hill_climbing() and hill_climbing_ordered() share: the best deck, the decks evaluated so far
+// and the candidates collected in par-candidates/race mode.
+struct Climb
+{
+    Deck* d1;
+    Process& proc;
+    const unsigned num_min_iterations;
+    const EvaluatedResults zero_results;
+    std::unique_ptr<ResultCache> result_cache;
+    unsigned num_cached_records{0};  // appended to result_cache
+    EvaluatedDecks evaluated_decks;
+    DeckFingerprint best_deck;
+    FinalResults<long double> best_score;
+    const Card* best_commander;
+    std::vector<const Card*> best_cards;
+    unsigned best_gap;
+    unsigned deck_cost;
+    bool deck_has_been_improved{true};
+    unsigned long skipped_simulations{0};
+    // the changes of d1 from the best deck, set by adjust_deck()
+    std::vector<std::pair<signed, const Card *>> cards_out, cards_in;
+    std::vector<ClimbCandidate> candidates;
+    // Shuffles the candidate cards and completes the decks (adjust_deck()). Seeded from the RNG seed
+    // alone: the random streams of the threads depend on how their battles were scheduled.
+    RandomEngine re;
+
+    // Evaluates d1, the deck to start from; gap: the one of its requirement.
+    Climb(Deck* d1_, Process& proc_, unsigned num_min_iterations_, unsigned gap) :
+        d1(d1_),
+        proc(proc_),
+        num_min_iterations(num_min_iterations_),
+        zero_results{EvaluatedResults::first_type(proc_.enemy_decks.size()), 0},
+        result_cache(open_result_cache(proc_, d1_)),
+        evaluated_decks(zero_results, result_cache ? &result_cache->results() : nullptr),
+        best_deck(d1_->fingerprint()),
+        best_commander(d1_->commander),
+        best_cards(d1_->cards),
+        best_gap(gap),
+        deck_cost(get_deck_cost(d1_))
+    {
+        seed_random_engine(re, mix64(proc.crn_seed));
+        proc.clear_crn_points();
+        auto emplace_rv = evaluated_decks.insert(best_deck);
+        if (!emplace_rv.second)
+        {
+            // from the cache
+            skipped_simulations += emplace_rv.first->second;
+        }
+        EvaluatedResults & results = proc.evaluate(num_min_iterations, *emplace_rv.first);
+        print_score_info(results, proc.factors);
+        best_score = compute_score(results, proc.factors);
+        fund = std::max(fund, deck_cost);
+        print_deck_inline(deck_cost, best_score, d1);
+    }
+
+    // fingerprint of d1: the one of the best deck with cards_out/cards_in swapped (not for ordered decks)
+    DeckFingerprint candidate_fingerprint() const
+    {
+        DeckFingerprint res = best_deck;
+        for (const auto & card_out: cards_out)
+        {
+            res.remove(card_out.second);
+        }
+        for (const auto & card_in: cards_in)
+        {
+            res.add(card_in.second);
+        }
+        assert(res == d1->fingerprint());
+        return res;
+    }
+
+    // d1, of fingerprint cur_deck and requirement gap new_gap, as a candidate: compared with the best
+    // deck at once, or collected for take_best_candidate() in par-candidates/race mode.
+    void try_candidate(const DeckFingerprint& cur_deck, unsigned new_gap)
+    {
+        auto emplace_rv = evaluated_decks.insert(cur_deck);
+        auto & prev_results = *emplace_rv.first;
+        if (!emplace_rv.second)
+        {
+            skipped_simulations += prev_results.second;
+        }
+        if (climb_candidates_parallel || climb_race)
+        {
+            if (std::none_of(candidates.begin(), candidates.end(), [&prev_results](const ClimbCandidate & candidate) { return candidate.results == &prev_results; }))
+            {
+                candidates.push_back({d1->commander, d1->cards, cur_deck, &prev_results, new_gap, deck_cost, cards_out, cards_in, 0, {}});
+            }
+            return;
+        }
+        // Evaluate new deck
+        assert(best_score.n_sims >= num_min_iterations);
+        auto compare_results = proc.compare(best_score.n_sims, prev_results, best_score);
+        auto current_score = compute_score(compare_results, proc.factors);
+        // Is it better ?
+        if (new_gap < best_gap || current_score.points > best_score.points + min_increment_of_score)
+        {
+            accept(cur_deck, prev_results, new_gap, cards_out, cards_in);
+        }
+        else
+        {
+            proc.reject_candidate(prev_results);
+        }
+    }
+
+    // par-candidates, race: compare the collected candidates and take the best improvement
+    void take_best_candidate()
+    {
+        if (candidates.empty())
+        { return; }
+        assert(best_score.n_sims >= num_min_iterations);
+        std::vector<const EvaluatedResults *> candidates_results;  // race_candidates() drops candidates
+        for (const auto & candidate: candidates)
+        {
+            candidates_results.push_back(candidate.results);
+        }
+        ClimbCandidate * candidate = climb_race ?
+            proc.race_candidates(best_score.n_sims, candidates, best_score, best_gap) :
+            proc.compare_candidates(best_score.n_sims, candidates, best_score, best_gap);
+        if (candidate)
+        {
+            d1->commander = candidate->commander;
+            d1->cards = candidate->cards;
+            deck_cost = candidate->deck_cost;
+            accept(candidate->fingerprint, *candidate->results, candidate->gap, candidate->cards_out, candidate->cards_in);
+        }
+        for (const EvaluatedResults * results: candidates_results)
+        {
+            proc.reject_candidate(*results);
+        }
+        candidates.clear();
+    }
+
+    // d1 becomes the best deck; print stuff
+    void accept(const DeckFingerprint& cur_deck, EvaluatedResults& results, unsigned gap,
+            const std::vector<std::pair<signed, const Card *>>& changes_out, const std::vector<std::pair<signed, const Card *>>& changes_in)
+    {
+        std::cout << "Deck improved: " << d1->hash() << ": " << card_slot_id_names(changes_out) << " -> " << card_slot_id_names(changes_in) << ": ";
+        best_gap = gap;
+        best_score = compute_score(results, proc.factors);
+        proc.accept_candidate(results);
+        best_deck = cur_deck;
+        best_commander = d1->commander;
+        best_cards = d1->cards;
+        deck_has_been_improved = true;
+        print_score_info(results, proc.factors);
+        print_deck_inline(deck_cost, best_score, d1);
+        // so that an interrupted climb keeps its battles
+        num_cached_records += save_result_cache(result_cache.get(), evaluated_decks);
+    }
+
+    // Re-evaluate the best deck
+    void refine(unsigned num_iterations)
+    {
+        auto & prev_results = evaluated_decks[best_deck];
+        skipped_simulations += prev_results.second;
+        auto & evaluate_result = proc.evaluate(std::min(prev_results.second * iterations_multiplier, num_iterations), prev_results);
+        best_score = compute_score(evaluate_result, proc.factors);
+        std::cout << "Results refined: ";
+        print_score_info(evaluate_result, proc.factors);
+        num_cached_records += save_result_cache(result_cache.get(), evaluated_decks);
+    }
+
+    void finish()
+    {
+        unsigned long simulations = 0;
+        for(const auto & evaluation: evaluated_decks)
+        { simulations += evaluation.second.second; }
+        simulations -= evaluated_decks.cached_simulations();  // counted in skipped_simulations
+        std::cout << "Evaluated " << evaluated_decks.size() << " decks (" << simulations << " + " << skipped_simulations << " simulations)." << std::endl;
+        if (result_cache)
+        {
+            num_cached_records += save_result_cache(result_cache.get(), evaluated_decks);
+            std::cout << "Cached " << num_cached_records << " records of results in " << result_cache_file << "." << std::endl;
+        }
+        std::cout << "Optimized Deck: ";
+        print_deck_inline(get_deck_cost(d1), best_score, d1);
+    }
+};
+//------------------------------------------------------------------------------
 void hill_climbing(unsigned num_min_iterations, unsigned num_iterations, Deck* d1, Process& proc, Requirement & requirement
-#ifndef NQUEST
     , Quest & quest
-#endif
 )
 {
-	EvaluatedResults zero_results = { EvaluatedResults::first_type(proc.enemy_decks.size()), 0 };
-    auto best_deck = d1->hash();
-    std::map<std::string, EvaluatedResults> evaluated_decks{{best_deck, zero_results}};
-    EvaluatedResults & results = proc.evaluate(num_min_iterations, evaluated_decks.begin()->second);
-    print_score_info(results, proc.factors);
-    auto current_score = compute_score(results, proc.factors);
-	auto best_score = current_score;
+    Climb climb(d1, proc, num_min_iterations, check_requirement(d1, requirement
+        , quest
+    ));
+    auto & best_score = climb.best_score;
     // Non-commander cards
     auto non_commander_cards = proc.cards.player_assaults;
     non_commander_cards.insert(non_commander_cards.end(), proc.cards.player_structures.begin(), proc.cards.player_structures.end());
     non_commander_cards.insert(non_commander_cards.end(), std::initializer_list<Card*>{NULL,});
-    const Card* best_commander = d1->commander;
-    std::vector<const Card*> best_cards = d1->cards;
-    unsigned deck_cost = get_deck_cost(d1);
-    fund = std::max(fund, deck_cost);
-    print_deck_inline(deck_cost, best_score, d1);
-    std::mt19937 & re = proc.threads_data[0]->re;
-    unsigned best_gap = check_requirement(d1, requirement
-#ifndef NQUEST
-        , quest
-#endif
-    );
-    bool deck_has_been_improved = true;
-    unsigned long skipped_simulations = 0;
-    std::vector<std::pair<signed, const Card *>> cards_out, cards_in;
-    for(unsigned slot_i(0), dead_slot(0); ; slot_i = (slot_i + 1) % std::min<unsigned>(max_deck_len, best_cards.size() + 1))
+    RandomEngine & re = climb.re;
+    for(unsigned slot_i(0), dead_slot(0); ; slot_i = (slot_i + 1) % std::min<unsigned>(max_deck_len, climb.best_cards.size() + 1))
     {
-        if (deck_has_been_improved)
+        if (climb.deck_has_been_improved)
         {
             dead_slot = slot_i;
-            deck_has_been_improved = false;
+            climb.deck_has_been_improved = false;
         }
         else if (slot_i == dead_slot || best_score.points - target_score > -1e-9)
         {
-            if (best_score.n_sims >= num_iterations || best_gap > 0)
+            if (best_score.n_sims >= num_iterations || climb.best_gap > 0)
             {
                 break;
             }
-            auto & prev_results = evaluated_decks[best_deck];
-            skipped_simulations += prev_results.second;
-            // Re-evaluate the best deck
-            auto evaluate_result = proc.evaluate(std::min(prev_results.second * iterations_multiplier, num_iterations), prev_results);
-            best_score = compute_score(evaluate_result, proc.factors);
-            std::cout << "Results refined: ";
-            print_score_info(evaluate_result, proc.factors);
+            climb.refine(num_iterations);
             dead_slot = slot_i;
         }
         if (best_score.points - target_score > -1e-9)
         {
             continue;
         }
-        if (requirement.num_cards.count(best_commander) == 0)
+        if (requirement.num_cards.count(climb.best_commander) == 0)
         {
             for(const Card* commander_candidate: proc.cards.player_commanders)
             {
                 // Various checks to check if the card is accepted
                 assert(commander_candidate->m_type == CardType::commander);
-                if (commander_candidate->m_name == best_commander->m_name)
+                if (commander_candidate->m_name == climb.best_commander->m_name)
                 { continue; }
-                d1->cards = best_cards;
+                d1->cards = climb.best_cards;
                 // Place it in the deck and restore other cards
-                cards_out.clear();
-                cards_out.emplace_back(-1, best_commander);
-                cards_out = {{-1, best_commander}};
+                climb.cards_out = {{-1, climb.best_commander}};
                 d1->commander = commander_candidate;
-                if (! adjust_deck(d1, -1, -1, nullptr, fund, re, deck_cost, cards_out, cards_in))
+                if (! adjust_deck(d1, -1, -1, nullptr, fund, re, climb.deck_cost, climb.cards_out, climb.cards_in))
                 { continue; }
                 unsigned new_gap = check_requirement(d1, requirement
-#ifndef NQUEST
                     , quest
-#endif
                 );
-                if (new_gap > 0 && new_gap >= best_gap)
+                if (new_gap > 0 && new_gap >= climb.best_gap)
                 { continue; }
-                auto && cur_deck = d1->hash();
-                auto && emplace_rv = evaluated_decks.insert({cur_deck, zero_results});
-                auto & prev_results = emplace_rv.first->second;
-                if (!emplace_rv.second)
-                {
-                    skipped_simulations += prev_results.second;
-                }
-                // Evaluate new deck
-				auto compare_results = proc.compare(best_score.n_sims, prev_results, best_score);
-				current_score = compute_score(compare_results, proc.factors);
-                // Is it better ?
-                if (new_gap < best_gap || current_score.points > best_score.points + min_increment_of_score)
-                {
-                    // Then update best score/commander, print stuff
-                    std::cout << "Deck improved: " << d1->hash() << ": " << card_slot_id_names(cards_out) << " -> " << card_slot_id_names(cards_in) << ": ";
-                    best_gap = new_gap;
-                    best_score = current_score;
-                    best_deck = cur_deck;
-                    best_commander = d1->commander;
-                    best_cards = d1->cards;
-                    deck_has_been_improved = true;
-                    print_score_info(compare_results, proc.factors);
-                    print_deck_inline(deck_cost, best_score, d1);
-                }
+                climb.try_candidate(climb.candidate_fingerprint(), new_gap);
             }
+            climb.take_best_candidate();
             // Now that all commanders are evaluated, take the best one
-            d1->commander = best_commander;
-            d1->cards = best_cards;
+            d1->commander = climb.best_commander;
+            d1->cards = climb.best_cards;
         }
         std::shuffle(non_commander_cards.begin(), non_commander_cards.end(), re);
         for(const Card* card_candidate: non_commander_cards)
@@ -1015,129 +1859,76 @@ void hill_climbing(unsigned num_min_iterations, unsigned num_iterations, Deck* d
             { continue; }
             if (card_candidate && d1->disallowed_candidates.count(card_candidate->m_id))
             { continue; }
-            d1->commander = best_commander;
-            d1->cards = best_cards;
+            d1->commander = climb.best_commander;
+            d1->cards = climb.best_cards;
             if (card_candidate ?
-                    (slot_i < best_cards.size() && card_candidate->m_name == best_cards[slot_i]->m_name)    // Omega -> Omega
+                    (slot_i < climb.best_cards.size() && card_candidate->m_name == climb.best_cards[slot_i]->m_name)    // Omega -> Omega
                     :
-                    (slot_i == best_cards.size()))  // void -> void
+                    (slot_i == climb.best_cards.size()))  // void -> void
             { continue; }
-            cards_out.clear();
+            climb.cards_out.clear();
             if (slot_i < d1->cards.size())
             {
-                cards_out.emplace_back(-1, d1->cards[slot_i]);
+                climb.cards_out.emplace_back(-1, d1->cards[slot_i]);
                 d1->cards.erase(d1->cards.begin() + slot_i);
             }
-            if (! adjust_deck(d1, slot_i, slot_i, card_candidate, fund, re, deck_cost, cards_out, cards_in) ||
+            if (! adjust_deck(d1, slot_i, slot_i, card_candidate, fund, re, climb.deck_cost, climb.cards_out, climb.cards_in) ||
                     d1->cards.size() < min_deck_len)
             { continue; }
             unsigned new_gap = check_requirement(d1, requirement
-#ifndef NQUEST
                 , quest
-#endif
             );
-            if (new_gap > 0 && new_gap >= best_gap)
+            if (new_gap > 0 && new_gap >= climb.best_gap)
             { continue; }
-            auto && cur_deck = d1->hash();
-            auto && emplace_rv = evaluated_decks.insert({cur_deck, zero_results});
-            auto & prev_results = emplace_rv.first->second;
-            if (!emplace_rv.second)
-            {
-                skipped_simulations += prev_results.second;
-            }
-            // Evaluate new deck
-            auto compare_results = proc.compare(best_score.n_sims, prev_results, best_score);
-            current_score = compute_score(compare_results, proc.factors);
-            // Is it better ?
-            if (new_gap < best_gap || current_score.points > best_score.points + min_increment_of_score)
-            {
-                // Then update best score/slot, print stuff
-                std::cout << "Deck improved: " << d1->hash() << ": " << card_slot_id_names(cards_out) << " -> " << card_slot_id_names(cards_in) << ": ";
-                best_gap = new_gap;
-                best_score = current_score;
-                best_deck = cur_deck;
-                best_commander = d1->commander;
-                best_cards = d1->cards;
-                deck_has_been_improved = true;
-                print_score_info(compare_results, proc.factors);
-                print_deck_inline(deck_cost, best_score, d1);
-            }
+            climb.try_candidate(climb.candidate_fingerprint(), new_gap);
             if(best_score.points - target_score > -1e-9)
             { break; }
         }
-        d1->commander = best_commander;
-        d1->cards = best_cards;
+        climb.take_best_candidate();
+        d1->commander = climb.best_commander;
+        d1->cards = climb.best_cards;
     }
-    unsigned simulations = 0;
-    for(auto evaluation: evaluated_decks)
-    { simulations += evaluation.second.second; }
-    std::cout << "Evaluated " << evaluated_decks.size() << " decks (" << simulations << " + " << skipped_simulations << " simulations)." << std::endl;
-    std::cout << "Optimized Deck: ";
-    print_deck_inline(get_deck_cost(d1), best_score, d1);
+    climb.finish();
 }
 //------------------------------------------------------------------------------
 void hill_climbing_ordered(unsigned num_min_iterations, unsigned num_iterations, Deck* d1, Process& proc, Requirement & requirement
-#ifndef NQUEST
     , Quest & quest
-#endif
 )
 {
-	EvaluatedResults zero_results = { EvaluatedResults::first_type(proc.enemy_decks.size()), 0 };
-    auto best_deck = d1->hash();
-    std::map<std::string, EvaluatedResults> evaluated_decks{{best_deck, zero_results}};
-    EvaluatedResults & results = proc.evaluate(num_min_iterations, evaluated_decks.begin()->second);
-    print_score_info(results, proc.factors);
-    auto current_score = compute_score(results, proc.factors);
-    auto best_score = current_score;
+    Climb climb(d1, proc, num_min_iterations, check_requirement(d1, requirement
+        , quest
+    ));
+    auto & best_score = climb.best_score;
     // Non-commander cards
     auto non_commander_cards = proc.cards.player_assaults;
     non_commander_cards.insert(non_commander_cards.end(), proc.cards.player_structures.begin(), proc.cards.player_structures.end());
     non_commander_cards.insert(non_commander_cards.end(), std::initializer_list<Card*>{NULL,});
-    const Card* best_commander = d1->commander;
-    std::vector<const Card*> best_cards = d1->cards;
-    unsigned deck_cost = get_deck_cost(d1);
-    fund = std::max(fund, deck_cost);
-    print_deck_inline(deck_cost, best_score, d1);
-    std::mt19937 & re = proc.threads_data[0]->re;
-    unsigned best_gap = check_requirement(d1, requirement
-#ifndef NQUEST
-        , quest
-#endif
-    );
-    bool deck_has_been_improved = true;
-    unsigned long skipped_simulations = 0;
-    std::vector<std::pair<signed, const Card *>> cards_out, cards_in;
+    RandomEngine & re = climb.re;
     for(unsigned from_slot(freezed_cards), dead_slot(freezed_cards); ; from_slot = (from_slot + 1) % std::min<unsigned>(max_deck_len, d1->cards.size() + 1))
     {
         if (from_slot < freezed_cards)
         {
             continue;
         }
-        if(deck_has_been_improved)
+        if(climb.deck_has_been_improved)
         {
             dead_slot = from_slot;
-            deck_has_been_improved = false;
+            climb.deck_has_been_improved = false;
         }
         else if (from_slot == dead_slot || best_score.points - target_score > -1e-9)
         {
-            if (best_score.n_sims >= num_iterations || best_gap > 0)
+            if (best_score.n_sims >= num_iterations || climb.best_gap > 0)
             {
                 break;
             }
-            auto & prev_results = evaluated_decks[best_deck];
-            skipped_simulations += prev_results.second;
-            // Re-evaluate the best deck
-            auto evaluate_result = proc.evaluate(std::min(prev_results.second * iterations_multiplier, num_iterations), prev_results);
-            best_score = compute_score(evaluate_result, proc.factors);
-            std::cout << "Results refined: ";
-            print_score_info(evaluate_result, proc.factors);
+            climb.refine(num_iterations);
             dead_slot = from_slot;
         }
         if (best_score.points - target_score > -1e-9)
         {
             continue;
         }
-        if (requirement.num_cards.count(best_commander) == 0)
+        if (requirement.num_cards.count(climb.best_commander) == 0)
         {
             for(const Card* commander_candidate: proc.cards.player_commanders)
             {
@@ -1145,50 +1936,26 @@ void hill_climbing_ordered(unsigned num_min_iterations, unsigned num_iterations,
                 { break; }
                 // Various checks to check if the card is accepted
                 assert(commander_candidate->m_type == CardType::commander);
-                if (commander_candidate->m_name == best_commander->m_name)
+                if (commander_candidate->m_name == climb.best_commander->m_name)
                 { continue; }
-                d1->cards = best_cards;
+                d1->cards = climb.best_cards;
                 // Place it in the deck
-                cards_out.clear();
-                cards_out.emplace_back(-1, best_commander);
+                climb.cards_out.clear();
+                climb.cards_out.emplace_back(-1, climb.best_commander);
                 d1->commander = commander_candidate;
-                if (! adjust_deck(d1, -1, -1, nullptr, fund, re, deck_cost, cards_out, cards_in))
+                if (! adjust_deck(d1, -1, -1, nullptr, fund, re, climb.deck_cost, climb.cards_out, climb.cards_in))
                 { continue; }
                 unsigned new_gap = check_requirement(d1, requirement
-#ifndef NQUEST
                     , quest
-#endif
                 );
-                if (new_gap > 0 && new_gap >= best_gap)
+                if (new_gap > 0 && new_gap >= climb.best_gap)
                 { continue; }
-                auto && cur_deck = d1->hash();
-                auto && emplace_rv = evaluated_decks.insert({cur_deck, zero_results});
-                auto & prev_results = emplace_rv.first->second;
-                if (!emplace_rv.second)
-                {
-                    skipped_simulations += prev_results.second;
-                }
-                // Evaluate new deck
-                auto compare_results = proc.compare(best_score.n_sims, prev_results, best_score);
-                current_score = compute_score(compare_results, proc.factors);
-                // Is it better ?
-                if (new_gap < best_gap || current_score.points > best_score.points + min_increment_of_score)
-                {
-                    std::cout << "Deck improved: " << d1->hash() << ": " << card_slot_id_names(cards_out) << " -> " << card_slot_id_names(cards_in) << ": ";
-                    // Then update best score/commander, print stuff
-                    best_gap = new_gap;
-                    best_score = current_score;
-                    best_deck = cur_deck;
-                    best_commander = commander_candidate;
-                    best_cards = d1->cards;
-                    deck_has_been_improved = true;
-                    print_score_info(compare_results, proc.factors);
-                    print_deck_inline(deck_cost, best_score, d1);
-                }
+                climb.try_candidate(d1->fingerprint(), new_gap);
             }
+            climb.take_best_candidate();
             // Now that all commanders are evaluated, take the best one
-            d1->commander = best_commander;
-            d1->cards = best_cards;
+            d1->commander = climb.best_commander;
+            d1->cards = climb.best_cards;
         }
         std::shuffle(non_commander_cards.begin(), non_commander_cards.end(), re);
         for(const Card* card_candidate: non_commander_cards)
@@ -1200,70 +1967,199 @@ void hill_climbing_ordered(unsigned num_min_iterations, unsigned num_iterations,
             { continue; }
             // Various checks to check if the card is accepted
             assert(!card_candidate || card_candidate->m_type != CardType::commander);
-            for(unsigned to_slot(card_candidate ? freezed_cards : best_cards.size() - 1); to_slot < best_cards.size() + (from_slot < best_cards.size() ? 0 : 1); ++to_slot)
+            for(unsigned to_slot(card_candidate ? freezed_cards : climb.best_cards.size() - 1); to_slot < climb.best_cards.size() + (from_slot < climb.best_cards.size() ? 0 : 1); ++to_slot)
             {
-                d1->commander = best_commander;
-                d1->cards = best_cards;
+                d1->commander = climb.best_commander;
+                d1->cards = climb.best_cards;
                 if (card_candidate ?
-                        (from_slot < best_cards.size() && (from_slot == to_slot && card_candidate->m_name == best_cards[to_slot]->m_name)) // 2 Omega -> 2 Omega
+                        (from_slot < climb.best_cards.size() && (from_slot == to_slot && card_candidate->m_name == climb.best_cards[to_slot]->m_name)) // 2 Omega -> 2 Omega
                         :
-                        (from_slot == best_cards.size())) // void -> void
+                        (from_slot == climb.best_cards.size())) // void -> void
                 { continue; }
-                cards_out.clear();
+                climb.cards_out.clear();
                 if (from_slot < d1->cards.size())
                 {
-                    cards_out.emplace_back(from_slot, d1->cards[from_slot]);
+                    climb.cards_out.emplace_back(from_slot, d1->cards[from_slot]);
                     d1->cards.erase(d1->cards.begin() + from_slot);
                 }
-                if (! adjust_deck(d1, from_slot, to_slot, card_candidate, fund, re, deck_cost, cards_out, cards_in) ||
+                if (! adjust_deck(d1, from_slot, to_slot, card_candidate, fund, re, climb.deck_cost, climb.cards_out, climb.cards_in) ||
                         d1->cards.size() < min_deck_len)
                 { continue; }
                 unsigned new_gap = check_requirement(d1, requirement
-#ifndef NQUEST
                     , quest
-#endif
                 );
-                if (new_gap > 0 && new_gap >= best_gap)
+                if (new_gap > 0 && new_gap >= climb.best_gap)
                 { continue; }
-                auto && cur_deck = d1->hash();
-                auto && emplace_rv = evaluated_decks.insert({cur_deck, zero_results});
-                auto & prev_results = emplace_rv.first->second;
-                if (!emplace_rv.second)
-                {
-                    skipped_simulations += prev_results.second;
-                }
-                // Evaluate new deck
-                auto compare_results = proc.compare(best_score.n_sims, prev_results, best_score);
-                current_score = compute_score(compare_results, proc.factors);
-                // Is it better ?
-                if (new_gap < best_gap || current_score.points > best_score.points + min_increment_of_score)
-                {
-                    // Then update best score/slot, print stuff
-                    std::cout << "Deck improved: " << d1->hash() << ": " << card_slot_id_names(cards_out) << " -> " << card_slot_id_names(cards_in) << ": ";
-                    best_gap = new_gap;
-                    best_score = current_score;
-                    best_deck = cur_deck;
-                    best_commander = d1->commander;
-                    best_cards = d1->cards;
-                    deck_has_been_improved = true;
-                    print_score_info(compare_results, proc.factors);
-                    print_deck_inline(deck_cost, best_score, d1);
-                }
+                climb.try_candidate(d1->fingerprint(), new_gap);
             }
             if(best_score.points - target_score > -1e-9)
             { break; }
         }
-        d1->commander = best_commander;
-        d1->cards = best_cards;
+        climb.take_best_candidate();
+        d1->commander = climb.best_commander;
+        d1->cards = climb.best_cards;
     }
-    unsigned simulations = 0;
-    for(auto evaluation: evaluated_decks)
-    { simulations += evaluation.second.second; }
-    std::cout << "Evaluated " << evaluated_decks.size() << " decks (" << simulations << " + " << skipped_simulations << " simulations)." << std::endl;
-    std::cout << "Optimized Deck: ";
-    print_deck_inline(get_deck_cost(d1), best_score, d1);
+    climb.finish();
 }
 //------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+// threadbench: how evaluate() and compare() scale with the number of threads.
+// For 1, 2, 4, ... threads up to max_threads, and for both iteration counts,
+// plays about num_large_iterations iterations in evaluate() calls of the attack
+// deck, then as many in compare() calls of the deck without its last card
+// against it (the typical case of climb: a worse candidate).
+void thread_benchmark(unsigned num_small_iterations, unsigned num_large_iterations, unsigned max_threads, Process& proc)
+{
+    typedef std::chrono::duration<long double> seconds;
+    std::vector<unsigned> thread_counts;
+    for (unsigned num_threads(1); num_threads < max_threads; num_threads *= 2)
+    {
+        thread_counts.push_back(num_threads);
+    }
+    thread_counts.push_back(std::max(1u, max_threads));
+    time_thread_waits = true;
+    std::cout << "threads  iterations  calls  evaluate sims/s  compare sims/s  barrier%  mutex%  stopped early" << std::endl;
+    for (unsigned num_threads: thread_counts)
+    {
+        Process bench_proc(num_threads, proc.cards, proc.decks, proc.your_deck, proc.enemy_decks, proc.factors, proc.gamemode,
+            proc.quest,
+            proc.bg_effects, proc.your_bg_skills, proc.enemy_bg_skills);
+        for (unsigned num_iterations: {num_small_iterations, num_large_iterations})
+        {
+            unsigned num_calls = std::max(1u, num_large_iterations / std::max(1u, num_iterations));
+            bench_proc.reset_thread_times();
+            auto start = std::chrono::steady_clock::now();
+            EvaluatedResults results{EvaluatedResults::first_type(proc.enemy_decks.size()), 0};
+            uint64_t num_sims(0);
+            for (unsigned i(0); i < num_calls; ++ i)
+            {
+                results = {EvaluatedResults::first_type(proc.enemy_decks.size()), 0};
+                num_sims += bench_proc.evaluate(num_iterations, results).second;
+            }
+            auto evaluate_time = std::chrono::steady_clock::now() - start;
+            long double evaluate_rate = num_sims / std::chrono::duration_cast<seconds>(evaluate_time).count();
+
+            long double compare_rate = 0;
+            unsigned num_compares(bench_proc.num_compares), num_compares_stopped(bench_proc.num_compares_stopped);
+            std::chrono::steady_clock::duration compare_time{0};
+            if (!proc.your_deck->cards.empty())
+            {
+                auto best_results = compute_score(results, proc.factors);
+                const Card* last_card = proc.your_deck->cards.back();
+                proc.your_deck->cards.pop_back();
+                start = std::chrono::steady_clock::now();
+                num_sims = 0;
+                for (unsigned i(0); i < num_calls; ++ i)
+                {
+                    EvaluatedResults compare_results{EvaluatedResults::first_type(proc.enemy_decks.size()), 0};
+                    num_sims += bench_proc.compare(num_iterations, compare_results, best_results).second;
+                }
+                compare_time = std::chrono::steady_clock::now() - start;
+                compare_rate = num_sims / std::chrono::duration_cast<seconds>(compare_time).count();
+                proc.your_deck->cards.push_back(last_card);
+            }
+            num_compares = bench_proc.num_compares - num_compares;
+            num_compares_stopped = bench_proc.num_compares_stopped - num_compares_stopped;
+
+            // shares of the time of all the threads
+            long double thread_time = std::chrono::duration_cast<seconds>(evaluate_time + compare_time).count() * num_threads;
+            std::cout << std::setw(7) << num_threads << std::setw(12) << num_iterations << std::setw(7) << num_calls
+                << std::fixed << std::setprecision(0)
+                << std::setw(17) << evaluate_rate << std::setw(16) << compare_rate
+                << std::setprecision(2)
+                << std::setw(10) << 100 * std::chrono::duration_cast<seconds>(bench_proc.barrier_time()).count() / thread_time
+                << std::setw(8) << 100 * std::chrono::duration_cast<seconds>(bench_proc.mutex_time()).count() / thread_time
+                << std::setw(11) << num_compares_stopped << "/" << num_compares
+                << std::defaultfloat << std::endl;
+        }
+    }
+    time_thread_waits = false;
+}
+#ifdef TUO_LOCKSTEP
+//------------------------------------------------------------------------------
+// lockstepbench: play() against the lockstep engine of lockstep.h, on num_battles battles against
+// each enemy deck, on one thread. Both engines first play the same battles from the same seed,
+// timed, and must give the same results; then the lockstep engine plays as many battles from
+// the seed that follows, whose win and loss rates are compared to those of play() (z: their
+// difference over its standard error).
+void lockstep_benchmark(unsigned num_battles, Process& proc)
+{
+    typedef std::chrono::duration<long double> seconds;
+    const unsigned num_rounds((num_battles + lockstep_lanes - 1) / lockstep_lanes);
+    num_battles = num_rounds * lockstep_lanes;
+    SimulationData sim(proc.crn_seed, proc.cards, proc.decks, proc.enemy_decks.size(), proc.factors, proc.gamemode,
+        proc.quest,
+        proc.bg_effects, proc.your_bg_skills, proc.enemy_bg_skills);
+    sim.set_decks(proc.your_deck, proc.enemy_decks);
+    LockstepBoard board;
+    Results<uint64_t> lane_results[lockstep_lanes];
+    std::vector<Results<uint64_t>> play_results(num_battles), lockstep_results(num_battles);
+    auto z = [num_battles](uint64_t a, uint64_t b) -> long double
+    {
+        long double p((a + b) / (2.0L * num_battles));
+        long double se(std::sqrt(p * (1 - p) * 2 / num_battles));
+        return(se > 0 ? ((long double)b - (long double)a) / num_battles / se : 0);
+    };
+    uint64_t num_mismatches(0);
+    std::cout << "deck  battles  in lanes%  mismatches  play() sims/s  lockstep sims/s  speedup  win% play()/lockstep      z  loss% play()/lockstep      z" << std::endl;
+    for (unsigned i(0); i < proc.enemy_decks.size(); ++ i)
+    {
+        Field* fd(sim.fields[i]);
+        const RandomEngine start_re(sim.re);
+        auto start = std::chrono::steady_clock::now();
+        for (auto & result: play_results)
+        {
+            sim.your_hand.reset(sim.re);
+            sim.enemy_hands[i]->reset(sim.re);
+            fd->reset();
+            result = play(fd);
+        }
+        long double play_time = std::chrono::duration_cast<seconds>(std::chrono::steady_clock::now() - start).count();
+
+        sim.re = start_re;
+        uint64_t num_lanes(0);
+        start = std::chrono::steady_clock::now();
+        for (unsigned round(0); round < num_rounds; ++ round)
+        {
+            num_lanes += play_lockstep(fd, board, lane_results);
+            std::copy(lane_results, lane_results + lockstep_lanes, lockstep_results.begin() + round * lockstep_lanes);
+        }
+        long double lockstep_time = std::chrono::duration_cast<seconds>(std::chrono::steady_clock::now() - start).count();
+        unsigned deck_mismatches(0);
+        for (unsigned battle(0); battle < num_battles; ++ battle)
+        {
+            const auto & a = play_results[battle];
+            const auto & b = lockstep_results[battle];
+            deck_mismatches += a.wins != b.wins || a.draws != b.draws || a.losses != b.losses || a.points != b.points;
+        }
+        num_mismatches += deck_mismatches;
+
+        // the lockstep engine on battles of its own, from the seed that follows
+        Results<uint64_t> play_total{0, 0, 0, 0}, lockstep_total{0, 0, 0, 0};
+        for (const auto & result: play_results) { play_total += result; }
+        for (unsigned round(0); round < num_rounds; ++ round)
+        {
+            play_lockstep(fd, board, lane_results);
+            for (const auto & result: lane_results) { lockstep_total += result; }
+        }
+
+        std::cout << std::setw(4) << i << std::setw(9) << num_battles
+            << std::fixed << std::setprecision(1)
+            << std::setw(11) << 100.0L * num_lanes / num_battles << std::setw(12) << deck_mismatches
+            << std::setprecision(0)
+            << std::setw(15) << num_battles / play_time << std::setw(17) << num_battles / lockstep_time
+            << std::setprecision(2)
+            << std::setw(9) << play_time / lockstep_time
+            << std::setw(12) << 100.0L * play_total.wins / num_battles << "/" << std::setw(6) << 100.0L * lockstep_total.wins / num_battles
+            << std::setw(7) << z(play_total.wins, lockstep_total.wins)
+            << std::setw(13) << 100.0L * play_total.losses / num_battles << "/" << std::setw(6) << 100.0L * lockstep_total.losses / num_battles
+            << std::setw(7) << z(play_total.losses, lockstep_total.losses)
+            << std::defaultfloat << std::endl;
+    }
+    std::cout << "Lockstep mismatches: " << num_mismatches << " in " << (uint64_t)num_battles * proc.enemy_decks.size() << " battles" << std::endl;
+}
+#endif
+//------------------------------------------------------------------------------
 enum Operation {
     noop,
     simulate,
@@ -1271,6 +2167,10 @@ enum Operation {
     reorder,
     debug,
     debuguntil,
+    threadbench,
+#ifdef TUO_LOCKSTEP
+    lockstepbench,
+#endif
 };
 //------------------------------------------------------------------------------
 extern void(*skill_table[Skill::num_skills])(Field*, CardStatus* src_status, const SkillSpec&);
@@ -1322,11 +2222,20 @@ void usage(int argc, char** argv)
         "  -o=<filename>: restrict to the owned cards listed in <filename>.\n"
         "  fund <num>: invest <num> SP to upgrade cards.\n"
         "  target <num>: stop as soon as the score reaches <num>.\n"
+        "  par-candidates: compare the candidates of a slot on separate threads (a whole candidate per thread) and take the best improvement.\n"
+        "  race: race the candidates of a slot by successive halving: all of them play a few battles, the worse half is dropped, the others play twice as many, and so on (a whole candidate per thread).\n"
+        "  neyman: spread the battles over the enemy decks in proportion to factor x standard deviation of their points (Neyman allocation) instead of one battle against each; not with crn.\n"
+        "  cache <file>: start every deck from its results in <file> and add the battles of the climb to them. The file can be shared by runs with the same enemy decks, BGEs, modes and cards.\n"
+        "  crn [<num>]: compare decks on common random numbers (battle #i of every deck uses the same seeds); the paired test starts after <num> battles (default 10).\n"
         "\n"
         "Operations:\n"
         "  sim <num>: simulate <num> battles to evaluate a deck.\n"
         "  climb <num>: perform hill-climbing starting from the given attack deck, using up to <num> battles to evaluate a deck.\n"
         "  reorder <num>: optimize the order for given attack deck, using up to <num> battles to evaluate an order.\n"
+        "  threadbench <small> <large>: benchmark evaluate and compare with 1, 2, 4, ... up to the given number of threads, calling them with <small> and with <large> iterations.\n"
+#ifdef TUO_LOCKSTEP
+        "  lockstepbench <num>: play <num> battles against each enemy deck with play() and with the lockstep engine, check that they agree and time them.\n"
+#endif
 #ifndef NDEBUG
         "  debug: testing purpose only. very verbose output. only one battle.\n"
         "  debuguntil <min> <max>: testing purpose only. fight until the last fight results in range [<min>, <max>]. recommend to redirect output.\n"
@@ -1491,9 +2400,7 @@ int main(int argc, char** argv)
     std::string opt_allow_candidates;
     std::string opt_disallow_candidates;
     std::string opt_disallow_recipes;
-#ifndef NQUEST
     std::string opt_quest;
-#endif
     std::string opt_target_score;
     std::vector<std::string> fn_suffix_list{"",};
     std::vector<std::string> opt_owned_cards_str_list;
@@ -1663,13 +2570,11 @@ int main(int argc, char** argv)
             use_fused_card_level = atoi(argv[argIndex+1]);
             argIndex += 1;
         }
-#ifndef NQUEST
         else if (strcmp(argv[argIndex], "quest") == 0)
         {
             opt_quest = argv[argIndex+1];
             argIndex += 1;
         }
-#endif
         else if(strcmp(argv[argIndex], "threads") == 0 || strcmp(argv[argIndex], "-t") == 0)
         {
             opt_num_threads = atoi(argv[argIndex+1]);
@@ -1703,6 +2608,32 @@ int main(int argc, char** argv)
         {
             use_harmonic_mean = true;
         }
+        else if(strcmp(argv[argIndex], "par-candidates") == 0)
+        {
+            climb_candidates_parallel = true;
+        }
+        else if(strcmp(argv[argIndex], "race") == 0)
+        {
+            climb_race = true;
+        }
+        else if(strcmp(argv[argIndex], "cache") == 0)
+        {
+            result_cache_file = argv[argIndex + 1];
+            argIndex += 1;
+        }
+        else if(strcmp(argv[argIndex], "neyman") == 0)
+        {
+            use_neyman = true;
+        }
+        else if(strcmp(argv[argIndex], "crn") == 0)
+        {
+            use_crn = true;
+            if(argIndex + 1 < argc && isdigit(argv[argIndex+1][0]))
+            {
+                crn_min_paired_sims = std::max(2, atoi(argv[argIndex+1]));
+                argIndex += 1;
+            }
+        }
         else if(strcmp(argv[argIndex], "seed") == 0)
         {
             sim_seed = atoi(argv[argIndex+1]);
@@ -1795,6 +2726,18 @@ int main(int argc, char** argv)
             opt_num_threads = 1;
             argIndex += 2;
         }
+        else if(strcmp(argv[argIndex], "threadbench") == 0)
+        {
+            opt_todo.push_back(std::make_tuple((unsigned)atoi(argv[argIndex + 1]), (unsigned)atoi(argv[argIndex + 2]), threadbench));
+            argIndex += 2;
+        }
+#ifdef TUO_LOCKSTEP
+        else if(strcmp(argv[argIndex], "lockstepbench") == 0)
+        {
+            opt_todo.push_back(std::make_tuple((unsigned)atoi(argv[argIndex + 1]), 0u, lockstepbench));
+            argIndex += 1;
+        }
+#endif
         else if(strcmp(argv[argIndex], "iter-mul") == 0 || strcmp(argv[argIndex], "iterations-multiplier") == 0)
         {
             iterations_multiplier = atoi(argv[argIndex+1]);
@@ -1814,6 +2757,11 @@ int main(int argc, char** argv)
     for (unsigned section = 1;
             load_cards_xml(all_cards, "data/cards_section_" + to_string(section) + ".xml", false);
             ++ section);
+    if (!result_cache_file.empty())
+    {
+        card_db_hash.add_file("data/skills_set.xml");
+        for (unsigned section = 1; card_db_hash.add_file("data/cards_section_" + to_string(section) + ".xml"); ++ section);
+    }
     all_cards.organize();
     for (const auto & suffix: fn_suffix_list)
     {
@@ -1966,7 +2914,6 @@ int main(int argc, char** argv)
         all_cards.cards_by_id[cid]->m_recipe_cards.clear();
     }
 
-#ifndef NQUEST
     if (!opt_quest.empty())
     {
         try
@@ -2102,7 +3049,6 @@ int main(int argc, char** argv)
             return 0;
         }
     }
-#endif
 
     try
     {
@@ -2211,6 +3157,67 @@ int main(int argc, char** argv)
     }
     freezed_cards = std::min<unsigned>(freezed_cards, your_deck->cards.size());
 
+    // The battles keep the units of a side in a Storage of max_board_units:
+    // check here that no deck can put more on the board (climb grows yours up to max_deck_len cards).
+    auto max_units_on_board = [](const Deck* deck, unsigned num_cards) -> unsigned
+    {
+        return deck->dominion_cards.size() + deck->fortress_cards.size() + std::min(num_cards, (turn_limit + 1) / 2);
+    };
+    std::vector<std::pair<const Deck*, unsigned>> board_decks{{your_deck, std::max<unsigned>(max_deck_len, your_deck->cards.size())}};
+    for (const Deck* enemy_deck: enemy_decks)
+    {
+        board_decks.emplace_back(enemy_deck, enemy_deck->deck_size);
+    }
+    for (const auto & board_deck: board_decks)
+    {
+        unsigned num_units = max_units_on_board(board_deck.first, board_deck.second);
+        if (num_units > max_board_units)
+        {
+            std::cerr << "Error: " << board_deck.first->short_description() << ": can put " << num_units
+                << " units on its side of the board, at most " << max_board_units << " are supported.\n";
+            return 0;
+        }
+    }
+
+    // Check the skill slots of the cards the decks and, when optimizing, the climb can field.
+    std::vector<const Card*> field_cards;
+    auto add_field_cards = [&field_cards](const Deck* deck)
+    {
+        field_cards.push_back(deck->commander);
+        field_cards.insert(field_cards.end(), deck->cards.begin(), deck->cards.end());
+        field_cards.insert(field_cards.end(), deck->fortress_cards.begin(), deck->fortress_cards.end());
+        field_cards.insert(field_cards.end(), deck->dominion_cards.begin(), deck->dominion_cards.end());
+        for (const auto & pool: deck->variable_cards)
+        {
+            field_cards.insert(field_cards.end(), std::get<2>(pool).begin(), std::get<2>(pool).end());
+        }
+    };
+    add_field_cards(your_deck);
+    for (const Deck* enemy_deck: enemy_decks)
+    {
+        add_field_cards(enemy_deck);
+    }
+    if (opt_do_optimization)
+    {
+        field_cards.insert(field_cards.end(), all_cards.player_cards.begin(), all_cards.player_cards.end());
+        for (const auto & owned_card: owned_cards)
+        {
+            field_cards.push_back(all_cards.by_id(owned_card.first));
+        }
+    }
+    std::sort(field_cards.begin(), field_cards.end());
+    field_cards.erase(std::unique(field_cards.begin(), field_cards.end()), field_cards.end());
+    field_cards.erase(std::remove(field_cards.begin(), field_cards.end(), nullptr), field_cards.end());
+    try
+    {
+        check_skill_slots(field_cards, opt_bg_skills[0], opt_bg_skills[1]);
+    }
+    catch (const std::runtime_error& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 0;
+    }
+
     if (debug_print >= 0)
     {
         std::cout << "Your Deck: " << (debug_print > 0 ? your_deck->long_description() : your_deck->medium_description()) << std::endl;
@@ -2241,9 +3248,7 @@ int main(int argc, char** argv)
     }
 
     Process p(opt_num_threads, all_cards, decks, your_deck, enemy_decks, enemy_decks_factors, gamemode,
-#ifndef NQUEST
         quest,
-#endif
         opt_bg_effects, opt_bg_skills[0], opt_bg_skills[1]);
 
     for(auto op: opt_todo)
@@ -2263,18 +3268,14 @@ int main(int argc, char** argv)
             {
             case DeckStrategy::random:
                 hill_climbing(std::get<0>(op), std::get<1>(op), your_deck, p, requirement
-#ifndef NQUEST
                     , quest
-#endif
                 );
                 break;
 //                case DeckStrategy::ordered:
 //                case DeckStrategy::exact_ordered:
             default:
                 hill_climbing_ordered(std::get<0>(op), std::get<1>(op), your_deck, p, requirement
-#ifndef NQUEST
                     , quest
-#endif
                 );
                 break;
             }
@@ -2293,9 +3294,7 @@ int main(int argc, char** argv)
             claim_cards({your_deck->commander});
             claim_cards(your_deck->cards);
             hill_climbing_ordered(std::get<0>(op), std::get<1>(op), your_deck, p, requirement
-#ifndef NQUEST
                 , quest
-#endif
             );
             break;
         }
@@ -2328,6 +3327,16 @@ int main(int argc, char** argv)
             -- debug_print;
             break;
         }
+        case threadbench: {
+            thread_benchmark(std::get<0>(op), std::get<1>(op), opt_num_threads, p);
+            break;
+        }
+#ifdef TUO_LOCKSTEP
+        case lockstepbench: {
+            lockstep_benchmark(std::get<0>(op), p);
+            break;
+        }
+#endif
         }
     }
     return 0;
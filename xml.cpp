@@ -248,8 +248,7 @@ void parse_card_node(Cards& all_cards, Card* card, xml_node<>* card_node)
 
     if (card_node->first_node("skill"))
     { // inherit no skill if there is skill node
-        card->m_skills.clear();
-        memset(card->m_skill_value, 0, sizeof card->m_skill_value);
+        card->clear_skills();
     }
     for(xml_node<>* skill_node = card_node->first_node("skill");
             skill_node;